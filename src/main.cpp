@@ -29,20 +29,102 @@
 #else
 #include <sys/types.h>
 #include <sys/stat.h>
-
-#include <cstdlib>
+#if !defined(_WIN32)
+#include <dirent.h>
+#endif  // _WIN32
 #endif  // C++17+
 
+#if defined(_WIN32)
+#include <direct.h>
+#include <fcntl.h>
+#include <io.h>
+#endif  // _WIN32
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif  // io_uring
+#endif  // __has_include
+#endif  // __linux__
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif  // __unix__ || __APPLE__
+
+// io_uring with the operations needed to read files (Linux 5.6+ headers)
+#if defined(IORING_FEAT_RW_CUR_POS) && defined(__NR_io_uring_setup)
+#define CPP_GENERES_IO_URING 1
+#endif  // io_uring
+
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cctype>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include <argparse/argparse.hpp>
 
 char constexpr version[] = "%(prog)s v0.1.0";
 
 namespace detail {
+inline std::string
+_absolute_path(std::string const& path)
+{
+#if __cplusplus >= 201703L
+    std::error_code ec;
+    auto res = std::filesystem::weakly_canonical(
+                std::filesystem::absolute(path.c_str()), ec);
+    return ec ? path : res.string();
+#elif defined(_WIN32)
+    char buffer[_MAX_PATH];
+    return _fullpath(buffer, path.c_str(), _MAX_PATH) ? buffer : path;
+#else
+    char* res = realpath(path.c_str(), nullptr);
+    if (!res) {
+        return path;
+    }
+    std::string str = res;
+    free(res);
+    return str;
+#endif  // C++17+
+}
+
 inline std::string
 _directory_name(std::string const& path)
 {
@@ -68,6 +150,28 @@ _ends_with(std::string const& s, std::string const& value)
 #endif  // C++20+
 }
 
+inline std::string
+_escape(std::string const& str)
+{
+    std::string res;
+    for (auto c : str) {
+        auto uc = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\' || c == '?') {
+            res += '\\';
+            res += c;
+        } else if (std::iscntrl(uc) || uc >= 0x80) {
+            char const digits[] = "01234567";
+            res += '\\';
+            res += digits[(uc >> 6) & 7];
+            res += digits[(uc >> 3) & 7];
+            res += digits[uc & 7];
+        } else {
+            res += c;
+        }
+    }
+    return res;
+}
+
 inline std::string
 _file_name(std::string const& path)
 {
@@ -78,6 +182,96 @@ _file_name(std::string const& path)
 #endif  // C++17+
 }
 
+inline bool
+_file_size(std::string const& path, uint64_t& size)
+{
+#if __cplusplus >= 201703L
+    std::error_code ec;
+    size = static_cast<uint64_t>(std::filesystem::file_size(path.c_str(), ec));
+    return !ec;
+#else
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || (info.st_mode & S_IFDIR)) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    return true;
+#endif  // C++17+
+}
+
+// matches a '/' separated path against a pattern where '*' and '?' don't
+// cross directories, '**/' matches any number of them and '[...]' is a set
+inline bool
+_glob_match(char const* pattern, char const* path)
+{
+    for (; *pattern; ++pattern, ++path) {
+        if (pattern[0] == '*' && pattern[1] == '*'
+                && (pattern[2] == '/' || pattern[2] == '\0')) {
+            if (pattern[2] == '\0') {
+                return true;
+            }
+            for (auto p = path; ; ++p) {
+                if ((p == path || p[-1] == '/')
+                        && _glob_match(pattern + 3, p)) {
+                    return true;
+                }
+                if (*p == '\0') {
+                    return false;
+                }
+            }
+        }
+        if (*pattern == '*') {
+            for (auto p = path; ; ++p) {
+                if (_glob_match(pattern + 1, p)) {
+                    return true;
+                }
+                if (*p == '\0' || *p == '/') {
+                    return false;
+                }
+            }
+        }
+        if (*path == '\0' || (*path == '/' && *pattern != '/')) {
+            return false;
+        }
+        if (*pattern == '[') {
+            auto end = pattern + 1;
+            bool negate = *end == '!' || *end == '^';
+            end += negate;
+            bool found = false;
+            for (auto first = end; *end && (*end != ']' || end == first);
+                 ++end) {
+                if (end[1] == '-' && end[2] && end[2] != ']') {
+                    found = found || (*path >= end[0] && *path <= end[2]);
+                    end += 2;
+                } else {
+                    found = found || *path == *end;
+                }
+            }
+            if (*end == '\0' || found == negate) {
+                return false;
+            }
+            pattern = end;
+        } else if (*pattern != '?' && *pattern != *path) {
+            return false;
+        }
+    }
+    return *path == '\0';
+}
+
+// turns 'str' into a valid C identifier
+inline std::string
+_identifier(std::string const& str)
+{
+    std::string res;
+    for (auto c : str) {
+        res += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    if (res.empty() || std::isdigit(static_cast<unsigned char>(res.front()))) {
+        res = "_" + res;
+    }
+    return res;
+}
+
 inline bool
 _is_directory_exists(std::string const& path)
 {
@@ -90,16 +284,180 @@ _is_directory_exists(std::string const& path)
 #endif  // C++17+
 }
 
+inline bool
+_is_path_exists(std::string const& path)
+{
+#if __cplusplus >= 201703L
+    std::filesystem::path p(path.c_str());
+    return std::filesystem::exists(p);
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+#endif  // C++17+
+}
+
+// appends the names of the files and subdirectories of 'path', symbolic
+// links to directories aren't followed
+inline bool
+_list_directory(std::string const& path, std::vector<std::string>& files,
+                std::vector<std::string>& dirs)
+{
+#if __cplusplus >= 201703L
+    std::error_code ec;
+    std::filesystem::directory_iterator it(path.c_str(), ec), end;
+    for (; !ec && it != end; it.increment(ec)) {
+        auto const name = it->path().filename().string();
+        std::error_code status_ec;
+        auto const is_link = it->is_symlink(status_ec);
+        auto const status = it->status(status_ec);
+        if (std::filesystem::is_regular_file(status)) {
+            files.push_back(name);
+        } else if (!is_link && std::filesystem::is_directory(status)) {
+            dirs.push_back(name);
+        }
+    }
+    return !ec;
+#elif defined(_WIN32)
+    (void)files;
+    (void)dirs;
+    std::cerr << "[FAIL] Can't list directory '" << path << "', directory "
+              << "inputs need C++17 on Windows" << std::endl;
+    return false;
+#else
+    auto dir = ::opendir(path.c_str());
+    if (!dir) {
+        return false;
+    }
+    while (auto entry = ::readdir(dir)) {
+        std::string const name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        auto type = entry->d_type;
+        if (type == DT_UNKNOWN || type == DT_LNK) {
+            struct stat info;
+            if (::stat((path + "/" + name).c_str(), &info) != 0) {
+                continue;
+            }
+            if (S_ISREG(info.st_mode)) {
+                type = DT_REG;
+            } else if (S_ISDIR(info.st_mode) && type == DT_UNKNOWN) {
+                type = DT_DIR;
+            } else {
+                continue;
+            }
+        }
+        if (type == DT_REG) {
+            files.push_back(name);
+        } else if (type == DT_DIR) {
+            dirs.push_back(name);
+        }
+    }
+    ::closedir(dir);
+    return true;
+#endif  // C++17+
+}
+
+// creates 'path' and its missing parents, true if it then exists (maybe
+// created by someone else meanwhile)
 inline bool
 _make_directory(std::string const& path)
 {
 #if __cplusplus >= 201703L
     std::filesystem::path dir(path.c_str());
-    return std::filesystem::create_directory(dir);
+    std::error_code error;
+    std::filesystem::create_directories(dir, error);
+#else
+    for (auto pos = path.find_first_of("/\\", 1);;
+         pos = path.find_first_of("/\\", pos + 1)) {
+        auto const dir = path.substr(0, pos);
+        if (!_is_directory_exists(dir)) {
+#if defined(_WIN32)
+            _mkdir(dir.c_str());
 #else
-    std::string command = "mkdir -p " + path;
-    return system(command.c_str()) == 0;
+            mkdir(dir.c_str(), 0777);
+#endif  // _WIN32
+        }
+        if (pos == std::string::npos) {
+            break;
+        }
+    }
 #endif  // C++17+
+    return _is_directory_exists(path);
+}
+
+// identifies the version of a file without reading it, empty if there is
+// no such file
+inline std::string
+_file_stamp(std::string const& path)
+{
+#if defined(__linux__)
+    // a save by renaming changes the inode, even within a timestamp tick
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return std::string();
+    }
+    return std::to_string(info.st_dev) + ":" + std::to_string(info.st_ino)
+            + ":" + std::to_string(info.st_mtim.tv_sec) + "."
+            + std::to_string(info.st_mtim.tv_nsec);
+#elif __cplusplus >= 201703L
+    std::filesystem::path file(path.c_str());
+    std::error_code error;
+    auto const time = std::filesystem::last_write_time(file, error);
+    return error ? std::string()
+                 : std::to_string(time.time_since_epoch().count());
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? std::to_string(info.st_mtime)
+                                          : std::string();
+#endif  // __linux__
+}
+
+// 'path' relative to the directory 'base', both absolute, with '/' as the
+// separator; 'path' itself if they are on different drives
+inline std::string
+_relative_path(std::string const& path, std::string const& base)
+{
+    auto const split = [] (std::string const& str)
+    {
+        std::vector<std::string> res;
+        std::string part;
+        for (auto c : str + "/") {
+            if (c != '/' && c != '\\') {
+                part += c;
+                continue;
+            }
+            if (part == ".." && !res.empty()) {
+                res.pop_back();
+            } else if (!part.empty() && part != ".") {
+                res.push_back(part);
+            }
+            part.clear();
+        }
+        return res;
+    };
+    auto const to = split(path);
+    auto const from = split(base);
+    auto const is_drive = [] (std::vector<std::string> const& parts)
+    { return !parts.empty() && parts.front().back() == ':'; };
+    if ((is_drive(to) || is_drive(from))
+            && (to.empty() || from.empty() || to.front() != from.front())) {
+        auto res = path;
+        std::replace(res.begin(), res.end(), '\\', '/');
+        return res;
+    }
+    std::size_t common = 0;
+    while (common < to.size() && common < from.size()
+           && to[common] == from[common]) {
+        ++common;
+    }
+    std::vector<std::string> parts(from.size() - common, "..");
+    parts.insert(parts.end(), to.begin() + std::ptrdiff_t(common), to.end());
+    std::string res;
+    for (auto const& part : parts) {
+        res += (res.empty() ? "" : "/") + part;
+    }
+    return res.empty() ? "." : res;
 }
 
 inline std::string
@@ -136,131 +494,8188 @@ _to_upper(std::string str)
     { return static_cast<char>(std::toupper(c)); });
     return str;
 }
-}  // namespace detail
 
-int main(int argc, char const* argv[])
+// file stored in a tar or zip archive
+struct Member
 {
-    auto const default_namespace = "resources";
-    auto const default_name = "resources";
-    auto const default_output = "resources.hpp";
+    Member()
+        : name(),
+          offset(),
+          size(),
+          packed(),
+          method()
+    { }
 
-    auto parser = argparse::ArgumentParser(argc, argv)
-            .description("Tool to generate C++ files with binary resources")
-            .epilog("by rue-ryuzaki (c) 2022-2023")
-            .fromfile_prefix_chars("@")
-            .formatter_class(argparse::ArgumentDefaultsHelpFormatter);
-    parser.add_argument("--version")
-            .action("version")
-            .version(version);
-    parser.add_argument("resources")
-            .action("extend")
-            .nargs("*")
-            .metavar("file:alias")
-            .type<std::pair<std::string, std::string> >()
-            .help("list of resources");
-    parser.add_argument("--guards")
-            .type<std::string>()
-            .choices({ "define", "pragma" })
-            .default_value("define")
-            .help("include guards");
-    parser.add_argument("--name")
-            .default_value(default_name)
-            .help("name for resources");
-    parser.add_argument("--namespace")
-            .type<std::string>()
-            .default_value(default_namespace)
-            .help("namespace for resources");
-    parser.add_argument("-o", "--output")
-            .metavar("file")
-            .type<std::string>()
-            .default_value(default_output)
-            .help("output file name");
-
-    auto const args = parser.parse_args();
-
-    auto guards = args.get<std::string>("guards");
-    auto name = args.get<std::string>("name");
-    if (name.empty()) {
-        name = default_name;
-    }
-    auto output = args.get<std::string>("output");
-    if (output.empty()) {
-        output = default_output;
-    }
-    if (!detail::_ends_with(output, ".h")
-            && !detail::_ends_with(output, ".hpp")) {
-        output += ".hpp";
-    }
-    auto name_space = args.get<std::string>("namespace");
-    if (name_space.empty()) {
-        name_space = default_namespace;
-    }
-    auto vec = args.get<
-          std::vector<std::pair<std::string, std::string> > >("resources", ':');
-
-    auto define = detail::_file_name(output);
-    define = detail::_replace(
-                define, [] (unsigned char c) { return std::iscntrl(c); }, "");
-    define = detail::_replace(
-                define, [] (unsigned char c) { return std::ispunct(c); }, "_");
-    define = detail::_replace(define, ' ', "_");
-    define = "_" + detail::_to_upper(name_space)
-            + "_" + detail::_to_upper(define) + "_";
-
-    auto dir = detail::_directory_name(output);
-    if (!dir.empty() && dir != "." && !detail::_is_directory_exists(dir)) {
-        if (!detail::_make_directory(dir)) {
-            std::cerr << "[FAIL] Can't create directory '" << dir
-                      << "' for output file '" << output << "'" << std::endl;
-            return 1;
+    std::string name;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t packed;
+    unsigned method;
+};
+
+struct Resource
+{
+    Resource()
+        : file(),
+          alias(),
+          size(),
+          data(),
+          member(),
+          preferred(),
+          filter(),
+          type(),
+          is_converted(),
+          encoding(),
+          etag(),
+          integrity(),
+          fingerprinted(),
+          mode(),
+          encoded()
+    { }
+
+    std::string file;
+    std::string alias;
+    uint64_t size;
+    std::vector<char> data;
+    Member member;
+    std::string preferred;
+    std::string filter;
+    std::string type;
+    bool is_converted;
+    // content coding of a precompressed variant, its HTTP entity tag and the
+    // subresource integrity hash of the decoded data
+    std::string encoding;
+    std::string etag;
+    std::string integrity;
+    // alias with a hash of the contents, for URLs that are cached forever
+    std::string fingerprinted;
+    std::string mode;
+    std::string encoded;
+};
+
+// resource as given on the command line or in a manifest:
+// file:alias[:mode][:type] where 'file' can also be a directory, a pattern
+// or an archive
+struct Input
+{
+    Input()
+        : file(),
+          alias(),
+          mode(),
+          type(),
+          member()
+    { }
+
+    std::string file;
+    std::string alias;
+    std::string mode;
+    std::string type;
+    Member member;
+};
+
+struct Options
+{
+    Options()
+        : guards(),
+          name(),
+          name_space(),
+          output(),
+          define(),
+          layout(),
+          lang(),
+          mode(),
+          arch(),
+          chunk_size(),
+          cxx(),
+          cc(),
+          inputs(),
+          given(),
+          manifest(),
+          cache_dir(),
+          filters(),
+          fingerprints(),
+          relative_to(),
+          content_hash(),
+          precompress(),
+          zero_copy(),
+          watch()
+    { }
+
+    std::string guards;
+    std::string name;
+    std::string name_space;
+    std::string output;
+    std::string define;
+    std::string layout;
+    std::string lang;
+    std::string mode;
+    std::string arch;
+    std::size_t chunk_size;
+    std::string cxx;
+    std::string cc;
+    std::vector<Input> inputs;
+    // the inputs as given, before directories, patterns and archives are
+    // expanded, to expand them again when --watch sees files come and go
+    std::vector<Input> given;
+    std::string manifest;
+    std::string cache_dir;
+    std::map<std::string, std::string> filters;
+    std::vector<std::string> fingerprints;
+    std::string relative_to;
+    bool content_hash;
+    // content codings of the variants made by --precompress
+    std::vector<std::string> precompress;
+    bool zero_copy;
+    bool watch;
+};
+
+// encoded data spliced into a generated file at 'offset' of its text
+struct Fragment
+{
+    Fragment()
+        : offset(),
+          data(),
+          file(),
+          begin(),
+          size()
+    { }
+
+    std::size_t offset;
+    std::string const* data;
+    // read from 'file' at 'begin' while writing, instead of from 'data'
+    std::string const* file;
+    std::size_t begin;
+    std::size_t size;
+};
+
+// generated file: the data is referenced rather than copied into the text,
+// so it is only copied once, into the output file
+struct Content
+{
+    Content()
+        : text(),
+          fragments()
+    { }
+
+    uint64_t
+    size() const
+    {
+        uint64_t res = text.size();
+        for (auto const& fragment : fragments) {
+            res += fragment.size;
         }
+        return res;
     }
 
-    std::ofstream file(output);
-    file << "// this file is auto-generated by the cpp-generes program\n";
-    file << "// see https://github.com/rue-ryuzaki/cpp-generes\n";
-    file << "\n";
-    if (guards == "define") {
-        file << "#ifndef " + define + "\n";
-        file << "#define " + define + "\n";
-    } else {
-        file << "#pragma once\n";
+    std::string text;
+    std::vector<Fragment> fragments;
+};
+
+// the text of a generated file, with the data it refers to as fragments
+class Output
+{
+public:
+    Output()
+        : m_text(),
+          m_fragments()
+    { }
+
+    Output(Output const&) = delete;
+    Output& operator =(Output const&) = delete;
+
+    template <typename T>
+    Output&
+    operator <<(T const& value)
+    {
+        m_text << value;
+        return *this;
     }
-    file << "\n";
-    file << "#include <cstdint>\n";
-    file << "#include <string>\n";
-    file << "#include <vector>\n";
-    file << "#include <unordered_map>\n";
-    file << "\n";
-    file << "namespace " << name_space << " {\n";
-    file << "static std::unordered_map<std::string, std::vector<uint8_t> > "
-            "const " << name << " =\n";
-    file << "{\n";
-    for (auto const& pair : vec) {
-        std::ifstream in(pair.first, std::ios::binary);
-        if (in.is_open()) {
-            auto buffer = std::vector<char>(std::istreambuf_iterator<char>(in),
-                                            std::istreambuf_iterator<char>());
-            file << "    { \"" << pair.second << "\", { ";
-            for (std::size_t i = 0; i < buffer.size(); ++i) {
-                file << uint32_t(uint8_t(buffer[i])) << ",";
-            }
-            file << " } },\n";
+
+    // for the writers that only add text
+    operator std::ostream&()
+    {
+        return m_text;
+    }
+
+    // refers to 'size' bytes of 'data' from 'begin' at the current position,
+    // 'data' has to outlive the content
+    void
+    splice(std::string const& data,
+           std::size_t begin = 0, std::size_t size = std::string::npos)
+    {
+        Fragment fragment;
+        fragment.offset = static_cast<std::size_t>(m_text.tellp());
+        fragment.data = &data;
+        fragment.begin = begin;
+        fragment.size = std::min(size, data.size() - begin);
+        m_fragments.push_back(fragment);
+    }
+
+    Content
+    content() const
+    {
+        Content res;
+        res.text = m_text.str();
+        res.fragments = m_fragments;
+        return res;
+    }
+
+private:
+    std::ostringstream m_text;
+    std::vector<Fragment> m_fragments;
+};
+
+// UTF-8 text transcoded to UTF-16 or UTF-32 code units
+inline bool
+_is_utf(std::string const& type)
+{
+    return type == "utf16" || type == "utf32";
+}
+
+// size in bytes of the elements of a typed resource, given by a type like
+// 'f32le': 'i' (signed), 'u' (unsigned) or 'f' (floating point), the bits
+// and the byte order of binary data ('le' if none); or 'utf16' and 'utf32'
+// for text. 0 if it isn't a type
+inline std::size_t
+_element_size(std::string const& type)
+{
+    if (_is_utf(type)) {
+        return type == "utf16" ? 2 : 4;
+    }
+    if (type.size() < 2 || (type[0] != 'i' && type[0] != 'u'
+                            && type[0] != 'f')) {
+        return 0;
+    }
+    auto const end = type.find_first_not_of("0123456789", 1);
+    auto const bits = type.substr(1, end == std::string::npos ? end : end - 1);
+    auto const order = end == std::string::npos ? std::string()
+                                                : type.substr(end);
+    if (!order.empty() && order != "le" && order != "be") {
+        return 0;
+    }
+    if (type[0] != 'f' && (bits == "8" || bits == "16")) {
+        return bits == "8" ? 1 : 2;
+    }
+    return bits == "32" ? 4 : bits == "64" ? 8 : 0;
+}
+
+// C and C++ name of the element type, C has no character types for UTF-16
+// and UTF-32 before C11
+inline std::string
+_element_name(std::string const& type, bool is_c = false)
+{
+    auto const size = _element_size(type);
+    if (_is_utf(type) && !is_c) {
+        return type == "utf16" ? "char16_t" : "char32_t";
+    }
+    if (type[0] == 'f') {
+        return size == 4 ? "float" : "double";
+    }
+    return (type[0] == 'u' ? "uint" : "int") + std::to_string(size * 8)
+            + "_t";
+}
+
+inline std::string
+_encode_bytes(std::vector<char> const& data)
+{
+    std::string res;
+    res.reserve(data.size() * 4);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        res += std::to_string(uint32_t(uint8_t(data[i])));
+        res += ',';
+    }
+    if (data.empty()) {
+        res += "0,";
+    }
+    return res;
+}
+
+// adjacent string literals; an unsigned char array initialized from them
+// also gets a terminating NUL past the data
+inline std::string
+_encode_string(std::vector<char> const& data)
+{
+    std::string res = "\"";
+    res.reserve(data.size() * 2);
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        if (i != 0 && i % 64 == 0) {
+            res += "\"\n    \"";
+        }
+        auto c = static_cast<unsigned char>(data[i]);
+        if (c == '"' || c == '\\' || c == '?') {
+            res += '\\';
+            res += static_cast<char>(c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            // always three digits, so a following digit can't extend it
+            res += '\\';
+            res += static_cast<char>('0' + ((c >> 6) & 7));
+            res += static_cast<char>('0' + ((c >> 3) & 7));
+            res += static_cast<char>('0' + (c & 7));
         } else {
-            std::cout << "[FAIL] Can't open file '" << pair.first << "'"
-                      << std::endl;
+            res += static_cast<char>(c);
         }
     }
-    file << "};\n";
-    file << "}  // namespace " << name_space << "\n";
-    if (guards == "define") {
-        file << "\n";
-        file << "#endif  // " + define + "\n";
+    res += '"';
+    return res;
+}
+
+// little-endian 64-bit words, the last one padded with zeros
+inline std::string
+_encode_words(std::vector<char> const& data)
+{
+    char const digits[] = "0123456789abcdef";
+    std::string res;
+    res.reserve(data.size() * 3);
+    for (std::size_t i = 0; i < data.size() || i == 0; i += 8) {
+        res += "0x";
+        for (std::size_t j = 8; j-- > 0; ) {
+            auto c = i + j < data.size()
+                    ? static_cast<unsigned char>(data[i + j]) : 0u;
+            res += digits[c >> 4];
+            res += digits[c & 15];
+        }
+        res += "ull,";
     }
-    file.flush();
-    file.close();
+    return res;
+}
 
-    std::cout << "[ OK ] File '" << output << "' generated" << std::endl;
+// raw string literals, split after a newline every few KiB for compilers
+// that limit their length; if the compiler might not read the data back
+// unchanged (control characters other than tab and newline, long lines,
+// invalid UTF-8, or any byte past ASCII unless 'is_utf8' says the sources
+// are read as UTF-8) the escaped literals of 'string' mode instead
+inline std::string
+_encode_raw(std::vector<char> const& data, bool is_utf8)
+{
+    std::size_t const piece_size = 2048;
+    std::size_t line = 0;
+    for (std::size_t i = 0; i < data.size(); ++i) {
+        auto c = static_cast<unsigned char>(data[i]);
+        line = c == '\n' ? 0 : line + 1;
+        auto count = c < 0x80 ? 0 : c >= 0xc2 && c < 0xe0 ? 1
+                                  : c >= 0xe0 && c < 0xf0 ? 2
+                                  : c >= 0xf0 && c < 0xf5 ? 3 : -1;
+        if ((c < 0x20 && c != '\t' && c != '\n') || c == 0x7f || count < 0
+                || (count > 0 && !is_utf8) || line > 2 * piece_size) {
+            return _encode_string(data);
+        }
+        for (; count > 0; --count) {
+            if (++i == data.size() || (data[i] & 0xc0) != 0x80) {
+                return _encode_string(data);
+            }
+        }
+    }
+    std::string const text(data.begin(), data.end());
+    std::string delimiter = "cpp_generes";
+    for (int i = 0; text.find(")" + delimiter + "\"") != std::string::npos;
+         ++i) {
+        delimiter = "cpp_generes" + std::to_string(i);
+    }
+    std::string res = "R\"" + delimiter + "(";
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\n' && i + 1 - begin >= piece_size
+                && i + 1 < text.size()) {
+            res.append(text, begin, i + 1 - begin);
+            res += ")" + delimiter + "\"\n    R\"" + delimiter + "(";
+            begin = i + 1;
+        }
+    }
+    res.append(text, begin, std::string::npos);
+    res += ")" + delimiter + "\"";
+    return res;
+}
+
+// literals of the little-endian elements of a typed resource, that
+// compilers lay out in the byte order and alignment of the target; text
+// also gets a terminating NUL past the data, as in 'string' mode
+inline std::string
+_encode_elements(Resource const& resource)
+{
+    auto const kind = resource.type[0];
+    auto const size = _element_size(resource.type);
+    auto const& data = resource.data;
+    std::string res;
+    res.reserve(data.size() * 3);
+    for (std::size_t i = 0; i + size <= data.size(); i += size) {
+        uint64_t bits = 0;
+        for (std::size_t j = size; j-- > 0; ) {
+            bits = bits << 8 | uint8_t(data[i + j]);
+        }
+        if (kind == 'f') {
+            double value = 0;
+            if (size == 4) {
+                auto const single_bits = uint32_t(bits);
+                float single = 0;
+                std::memcpy(&single, &single_bits, sizeof(single));
+                value = double(single);
+            } else {
+                std::memcpy(&value, &bits, sizeof(value));
+            }
+            if (std::isnan(value)) {
+                res += "NAN";
+            } else if (std::isinf(value)) {
+                res += value < 0 ? "-INFINITY" : "INFINITY";
+            } else {
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer),
+                              size == 4 ? "%.9g" : "%.17g", value);
+                std::string str = buffer;
+                if (str.find_first_of(".e") == std::string::npos) {
+                    str += ".0";
+                }
+                res += size == 4 ? str + "f" : str;
+            }
+        } else if (kind == 'i') {
+            // sign extension
+            if (size < 8 && (bits >> (8 * size - 1)) != 0) {
+                bits |= ~uint64_t(0) << (8 * size);
+            }
+            res += bits == uint64_t(1) << 63 ? "(-9223372036854775807ll - 1)"
+                                             : std::to_string(int64_t(bits));
+        } else {
+            res += std::to_string(bits);
+            res += size == 8 ? "ull" : size == 4 ? "u" : "";
+        }
+        res += ',';
+    }
+    if (data.size() < size || _is_utf(resource.type)) {
+        res += "0,";
+    }
+    return res;
+}
 
-    return 0;
+inline std::string
+_encode(Resource const& resource)
+{
+    if (!resource.type.empty()) {
+        return _encode_elements(resource);
+    }
+    if (resource.mode == "array") {
+        return _encode_bytes(resource.data);
+    }
+    if (resource.mode == "string") {
+        return _encode_string(resource.data);
+    }
+    if (resource.mode == "raw" || resource.mode == "raw-utf8") {
+        return _encode_raw(resource.data, resource.mode == "raw-utf8");
+    }
+    if (resource.mode == "words") {
+        return _encode_words(resource.data);
+    }
+    return std::string();
+}
+
+// SHA-256 (FIPS 180-4) digest
+class Sha256
+{
+public:
+    Sha256()
+        : m_state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+          m_block(),
+          m_used(),
+          m_length()
+    { }
+
+    Sha256&
+    update(char const* data, std::size_t size)
+    {
+        m_length += size;
+        while (size != 0) {
+            auto count = std::min(size, sizeof(m_block) - m_used);
+            std::memcpy(m_block + m_used, data, count);
+            m_used += count;
+            data += count;
+            size -= count;
+            if (m_used == sizeof(m_block)) {
+                transform();
+                m_used = 0;
+            }
+        }
+        return *this;
+    }
+
+    // lowercase hexadecimal digest, the object can't be updated after it
+    std::string
+    hex()
+    {
+        auto const bits = m_length * 8;
+        unsigned char pad[72] = { 0x80 };
+        auto const count = (m_used < 56 ? 56 : 120) - m_used;
+        for (std::size_t i = 0; i < 8; ++i) {
+            pad[count + i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+        }
+        update(reinterpret_cast<char const*>(pad), count + 8);
+        char const digits[] = "0123456789abcdef";
+        std::string res;
+        for (auto word : m_state) {
+            for (int shift = 28; shift >= 0; shift -= 4) {
+                res += digits[(word >> shift) & 15];
+            }
+        }
+        return res;
+    }
+
+private:
+    static uint32_t
+    rotate(uint32_t value, int count)
+    {
+        return value >> count | value << (32 - count);
+    }
+
+    void
+    transform()
+    {
+        static uint32_t const k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+            0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+            0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+            0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+            0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+            0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+            0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+            0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+            0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+            0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+            0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+            0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for (std::size_t i = 0; i < 16; ++i) {
+            w[i] = uint32_t(m_block[4 * i]) << 24
+                    | uint32_t(m_block[4 * i + 1]) << 16
+                    | uint32_t(m_block[4 * i + 2]) << 8
+                    | uint32_t(m_block[4 * i + 3]);
+        }
+        for (std::size_t i = 16; i < 64; ++i) {
+            auto s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18)
+                    ^ w[i - 15] >> 3;
+            auto s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19)
+                    ^ w[i - 2] >> 10;
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t v[8];
+        std::copy(m_state, m_state + 8, v);
+        for (std::size_t i = 0; i < 64; ++i) {
+            auto s1 = rotate(v[4], 6) ^ rotate(v[4], 11) ^ rotate(v[4], 25);
+            auto ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            auto t1 = v[7] + s1 + ch + k[i] + w[i];
+            auto s0 = rotate(v[0], 2) ^ rotate(v[0], 13) ^ rotate(v[0], 22);
+            auto maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            std::copy_backward(v, v + 7, v + 8);
+            v[4] += t1;
+            v[0] = t1 + s0 + maj;
+        }
+        for (std::size_t i = 0; i < 8; ++i) {
+            m_state[i] += v[i];
+        }
+    }
+
+    uint32_t m_state[8];
+    unsigned char m_block[64];
+    std::size_t m_used;
+    uint64_t m_length;
+};
+
+// SHA-384 (FIPS 180-4): SHA-512 with its own initial values, truncated
+class Sha384
+{
+public:
+    Sha384()
+        : m_state{ 0xcbbb9d5dc1059ed8ull, 0x629a292a367cd507ull,
+                   0x9159015a3070dd17ull, 0x152fecd8f70e5939ull,
+                   0x67332667ffc00b31ull, 0x8eb44a8768581511ull,
+                   0xdb0c2e0d64f98fa7ull, 0x47b5481dbefa4fa4ull },
+          m_block(),
+          m_used(),
+          m_length()
+    { }
+
+    Sha384&
+    update(char const* data, std::size_t size)
+    {
+        m_length += size;
+        while (size != 0) {
+            auto count = std::min(size, sizeof(m_block) - m_used);
+            std::memcpy(m_block + m_used, data, count);
+            m_used += count;
+            data += count;
+            size -= count;
+            if (m_used == sizeof(m_block)) {
+                transform();
+                m_used = 0;
+            }
+        }
+        return *this;
+    }
+
+    // the 48 bytes of the digest, the object can't be updated after it
+    std::string
+    digest()
+    {
+        auto const bits = m_length * 8;
+        unsigned char pad[144] = { 0x80 };
+        auto const count = (m_used < 112 ? 112 : 240) - m_used;
+        // the upper half of the 128-bit length stays zero
+        for (std::size_t i = 0; i < 8; ++i) {
+            pad[count + 8 + i]
+                    = static_cast<unsigned char>(bits >> (56 - 8 * i));
+        }
+        update(reinterpret_cast<char const*>(pad), count + 16);
+        std::string res;
+        for (std::size_t i = 0; i < 6; ++i) {
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                res += static_cast<char>(m_state[i] >> shift);
+            }
+        }
+        return res;
+    }
+
+private:
+    static uint64_t
+    rotate(uint64_t value, int count)
+    {
+        return value >> count | value << (64 - count);
+    }
+
+    void
+    transform()
+    {
+        static uint64_t const k[80] = {
+            0x428a2f98d728ae22ull, 0x7137449123ef65cdull, 0xb5c0fbcfec4d3b2full,
+            0xe9b5dba58189dbbcull, 0x3956c25bf348b538ull, 0x59f111f1b605d019ull,
+            0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull, 0xd807aa98a3030242ull,
+            0x12835b0145706fbeull, 0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+            0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull, 0x9bdc06a725c71235ull,
+            0xc19bf174cf692694ull, 0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull,
+            0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull, 0x2de92c6f592b0275ull,
+            0x4a7484aa6ea6e483ull, 0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+            0x983e5152ee66dfabull, 0xa831c66d2db43210ull, 0xb00327c898fb213full,
+            0xbf597fc7beef0ee4ull, 0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull,
+            0x06ca6351e003826full, 0x142929670a0e6e70ull, 0x27b70a8546d22ffcull,
+            0x2e1b21385c26c926ull, 0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+            0x650a73548baf63deull, 0x766a0abb3c77b2a8ull, 0x81c2c92e47edaee6ull,
+            0x92722c851482353bull, 0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull,
+            0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull, 0xd192e819d6ef5218ull,
+            0xd69906245565a910ull, 0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+            0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull, 0x2748774cdf8eeb99ull,
+            0x34b0bcb5e19b48a8ull, 0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull,
+            0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull, 0x748f82ee5defb2fcull,
+            0x78a5636f43172f60ull, 0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+            0x90befffa23631e28ull, 0xa4506cebde82bde9ull, 0xbef9a3f7b2c67915ull,
+            0xc67178f2e372532bull, 0xca273eceea26619cull, 0xd186b8c721c0c207ull,
+            0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull, 0x06f067aa72176fbaull,
+            0x0a637dc5a2c898a6ull, 0x113f9804bef90daeull, 0x1b710b35131c471bull,
+            0x28db77f523047d84ull, 0x32caab7b40c72493ull, 0x3c9ebe0a15c9bebcull,
+            0x431d67c49c100d4cull, 0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull,
+            0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull
+        };
+        uint64_t w[80];
+        for (std::size_t i = 0; i < 16; ++i) {
+            w[i] = 0;
+            for (std::size_t j = 0; j < 8; ++j) {
+                w[i] = w[i] << 8 | m_block[8 * i + j];
+            }
+        }
+        for (std::size_t i = 16; i < 80; ++i) {
+            auto s0 = rotate(w[i - 15], 1) ^ rotate(w[i - 15], 8)
+                    ^ w[i - 15] >> 7;
+            auto s1 = rotate(w[i - 2], 19) ^ rotate(w[i - 2], 61)
+                    ^ w[i - 2] >> 6;
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint64_t v[8];
+        std::copy(m_state, m_state + 8, v);
+        for (std::size_t i = 0; i < 80; ++i) {
+            auto s1 = rotate(v[4], 14) ^ rotate(v[4], 18) ^ rotate(v[4], 41);
+            auto ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+            auto t1 = v[7] + s1 + ch + k[i] + w[i];
+            auto s0 = rotate(v[0], 28) ^ rotate(v[0], 34) ^ rotate(v[0], 39);
+            auto maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+            std::copy_backward(v, v + 7, v + 8);
+            v[4] += t1;
+            v[0] = t1 + s0 + maj;
+        }
+        for (std::size_t i = 0; i < 8; ++i) {
+            m_state[i] += v[i];
+        }
+    }
+
+    uint64_t m_state[8];
+    unsigned char m_block[128];
+    std::size_t m_used;
+    uint64_t m_length;
+};
+
+// standard base64 (RFC 4648) with padding
+inline std::string
+_base64(std::string const& data)
+{
+    char const digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+                          "0123456789+/";
+    std::string res;
+    for (std::size_t i = 0; i < data.size(); i += 3) {
+        uint32_t value = uint32_t(uint8_t(data[i])) << 16;
+        if (i + 1 < data.size()) {
+            value |= uint32_t(uint8_t(data[i + 1])) << 8;
+        }
+        if (i + 2 < data.size()) {
+            value |= uint8_t(data[i + 2]);
+        }
+        res += digits[value >> 18];
+        res += digits[value >> 12 & 63];
+        res += i + 1 < data.size() ? digits[value >> 6 & 63] : '=';
+        res += i + 2 < data.size() ? digits[value & 63] : '=';
+    }
+    return res;
+}
+
+// CRC-32 (ISO 3309) of gzip members and cached fragments
+inline uint32_t
+_crc32(char const* data, std::size_t size)
+{
+    static std::vector<uint32_t> const table = [] ()
+    {
+        std::vector<uint32_t> res(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            auto value = i;
+            for (int j = 0; j < 8; ++j) {
+                value = (value & 1) != 0 ? 0xedb88320 ^ value >> 1
+                                         : value >> 1;
+            }
+            res[i] = value;
+        }
+        return res;
+    }();
+    uint32_t res = 0xffffffff;
+    for (std::size_t i = 0; i < size; ++i) {
+        res = table[(res ^ uint8_t(data[i])) & 0xff] ^ res >> 8;
+    }
+    return ~res;
+}
+
+// fragments encoded from at least this much data are kept in --cache-dir
+std::size_t constexpr cached_size = std::size_t(1) << 16;
+// changes whenever an encoding or a built-in filter does, so that older
+// fragments and filter outputs aren't used
+char const* const cache_format = "3";
+
+// reads an entry of the store, false if there is none or it is damaged:
+// every entry ends with the CRC-32 of its contents, damaged ones are removed
+// to be written again
+template <class T>
+bool
+_load_cached(std::string const& path, T& res)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    auto const size = static_cast<std::size_t>(in.tellg());
+    unsigned char crc[4];
+    res.resize(size < sizeof(crc) ? 0 : size - sizeof(crc));
+    in.seekg(0);
+    if (res.empty() || !in.read(&res[0], std::streamsize(res.size()))
+            || !in.read(reinterpret_cast<char*>(crc), sizeof(crc))) {
+        return false;
+    }
+    auto const expected = _crc32(&res[0], res.size());
+    for (std::size_t i = 0; i < sizeof(crc); ++i) {
+        if (crc[i] != ((expected >> (8 * i)) & 0xff)) {
+            std::cout << "[WARN] Cached entry '" << path << "' is damaged"
+                      << std::endl;
+            std::remove(path.c_str());
+            res.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// writes an entry of the store to a temporary file that is then renamed, so
+// generators running concurrently never see it partially written
+inline void
+_store_cached(std::string const& path, char const* data, std::size_t size)
+{
+    auto const temporary = path + ".tmp"
+            + std::to_string(std::random_device()());
+    auto const crc = _crc32(data, size);
+    char trailer[4];
+    for (std::size_t i = 0; i < sizeof(trailer); ++i) {
+        trailer[i] = static_cast<char>((crc >> (8 * i)) & 0xff);
+    }
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(data, std::streamsize(size));
+    out.write(trailer, sizeof(trailer));
+    out.close();
+    // an entry renamed by another generator meanwhile is the same one
+    if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+    }
+}
+
+// data that isn't a file or a stored part of one, or has been filtered or
+// converted to elements, so it has to be held in memory and can't be
+// referenced by path
+inline bool
+_is_in_memory(Resource const& resource)
+{
+    return resource.file == "-" || resource.member.method != 0
+            || !resource.filter.empty() || !resource.type.empty();
+}
+
+// whether the fragment of 'resource' is worth keeping in the store in
+// 'directory'
+inline bool
+_is_cached(Resource const& resource, std::string const& directory)
+{
+    return !directory.empty() && resource.size >= cached_size;
+}
+
+// path of the fragment in the store in 'directory' of data with the SHA-256
+// 'hash' in the mode and type of 'resource'. Fragments are named by their
+// data only, so that checkouts and machines sharing the store find them.
+inline std::string
+_fragment_path(Resource const& resource,
+               std::string const& hash,
+               std::string const& directory)
+{
+    return directory + "/" + hash + "-" + resource.mode
+            + (resource.type.empty() ? "" : "-" + resource.type) + "-"
+            + cache_format;
+}
+
+// path of the local index entry of a file resource, named by its path,
+// version and place in the file, that holds the SHA-256 of its data so that
+// unchanged files don't have to be read; empty for data only in memory
+inline std::string
+_index_path(Resource const& resource, std::string const& directory)
+{
+    if (_is_in_memory(resource)) {
+        return std::string();
+    }
+    auto const stamp = _file_stamp(resource.file);
+    if (stamp.empty()) {
+        return std::string();
+    }
+    auto const key = resource.file + "\n" + stamp + "\n"
+            + std::to_string(resource.member.offset) + "\n"
+            + std::to_string(resource.size);
+    return directory + "/index-" + Sha256().update(key.data(), key.size())
+            .hex() + "-" + cache_format;
+}
+
+// sets the encoding of 'resource' from the store in 'directory', false if
+// it has none; data that isn't read yet is looked up by the index
+inline bool
+_load_encoded(Resource& resource, std::string const& directory)
+{
+    if (!_is_cached(resource, directory)) {
+        return false;
+    }
+    std::string hash;
+    if (resource.data.size() == resource.size) {
+        hash = Sha256().update(resource.data.data(), resource.data.size())
+                .hex();
+    } else {
+        auto const index = _index_path(resource, directory);
+        if (index.empty() || !_load_cached(index, hash)) {
+            return false;
+        }
+    }
+    return _load_cached(_fragment_path(resource, hash, directory),
+                        resource.encoded);
+}
+
+// encodes the read 'resource', or takes its fragment from the store in
+// 'directory' if it is given and has it, keeping the fragment and the index
+// entry of its file there
+inline std::string
+_encode(Resource const& resource, std::string const& directory)
+{
+    if (!_is_cached(resource, directory)
+            || resource.data.size() != resource.size) {
+        return _encode(resource);
+    }
+    auto const hash = Sha256().update(resource.data.data(),
+                                      resource.data.size()).hex();
+    auto const path = _fragment_path(resource, hash, directory);
+    std::string res;
+    if (!_load_cached(path, res)) {
+        res = _encode(resource);
+        if (res.empty()) {
+            return res;
+        }
+        _store_cached(path, res.data(), res.size());
+    }
+    auto const index = _index_path(resource, directory);
+    if (!index.empty()) {
+        _store_cached(index, hash.data(), hash.size());
+    }
+    return res;
+}
+
+// splits a comma-terminated encoded initializer into pieces of 'chunk'
+// values, given as (offset, size) ranges
+inline std::vector<std::pair<std::size_t, std::size_t> >
+_split_encoded(std::string const& encoded, std::size_t chunk)
+{
+    std::vector<std::pair<std::size_t, std::size_t> > res;
+    std::size_t begin = 0;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < encoded.size(); ++i) {
+        if (encoded[i] == ',' && ++count == chunk) {
+            res.push_back(std::make_pair(begin, i + 1 - begin));
+            begin = i + 1;
+            count = 0;
+        }
+    }
+    if (begin < encoded.size()) {
+        res.push_back(std::make_pair(begin, encoded.size() - begin));
+    }
+    return res;
+}
+
+// splits 'file:alias[:mode][:type]', the alias itself may contain ':' and
+// is a prefix if the file is a directory or a pattern (see _expand_inputs)
+inline bool
+_parse_input(std::string const& spec, Input& input)
+{
+    auto pos = spec.find(':');
+    if (pos == std::string::npos || pos == 0) {
+        std::cerr << "[FAIL] Resource '" << spec << "' must be given as "
+                  << "file:alias[:mode][:type]" << std::endl;
+        return false;
+    }
+    input.file = spec.substr(0, pos);
+    input.alias = spec.substr(pos + 1);
+    input.mode.clear();
+    input.type.clear();
+    auto last = input.alias.rfind(':');
+    if (last != std::string::npos
+            && _element_size(input.alias.substr(last + 1)) != 0) {
+        input.type = input.alias.substr(last + 1);
+        input.alias.resize(last);
+        last = input.alias.rfind(':');
+    }
+    if (last != std::string::npos) {
+        auto const mode = input.alias.substr(last + 1);
+        for (auto name : { "array", "string", "raw", "raw-utf8", "words",
+                           "embed", "incbin", "object", "auto" }) {
+            if (mode == name) {
+                input.mode = mode;
+                input.alias.resize(last);
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+// splits 'ext=command', the extension may be given with its leading dot
+inline bool
+_parse_filter(std::string const& spec, Options& options)
+{
+    auto pos = spec.find('=');
+    auto begin = std::size_t(!spec.empty() && spec[0] == '.');
+    if (pos == std::string::npos || pos <= begin || pos + 1 == spec.size()) {
+        std::cerr << "[FAIL] Filter '" << spec << "' must be given as "
+                  << "ext=command" << std::endl;
+        return false;
+    }
+    options.filters[spec.substr(begin, pos - begin)] = spec.substr(pos + 1);
+    return true;
+}
+
+// splits the comma separated content codings of --precompress
+inline bool
+_parse_precompress(std::string const& spec, Options& options)
+{
+    std::size_t begin = 0;
+    while (begin < spec.size()) {
+        auto end = spec.find(',', begin);
+        if (end == std::string::npos) {
+            end = spec.size();
+        }
+        auto const coding = spec.substr(begin, end - begin);
+        if (coding != "gzip" && coding != "br") {
+            std::cerr << "[FAIL] Unknown content coding '" << coding
+                      << "' in --precompress, expected 'gzip' or 'br'"
+                      << std::endl;
+            return false;
+        }
+        if (std::find(options.precompress.begin(), options.precompress.end(),
+                      coding) == options.precompress.end()) {
+            options.precompress.push_back(coding);
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+// decoder of raw deflate streams (RFC 1951), as stored in zip archives
+class Inflater
+{
+public:
+    Inflater(char const* data, std::size_t size)
+        : m_data(reinterpret_cast<unsigned char const*>(data)),
+          m_size(size),
+          m_pos(),
+          m_bits(),
+          m_count(),
+          m_is_valid(true),
+          m_out()
+    { }
+
+    Inflater(Inflater const&) = delete;
+    Inflater& operator =(Inflater const&) = delete;
+
+    // appends the inflated data to 'out', false if the stream is malformed
+    bool
+    inflate(std::vector<char>& out)
+    {
+        m_out = &out;
+        for (bool is_last = false; !is_last && m_is_valid; ) {
+            is_last = bits(1) != 0;
+            switch (bits(2)) {
+                case 0 :
+                    stored();
+                    break;
+                case 1 :
+                    fixed();
+                    break;
+                case 2 :
+                    dynamic();
+                    break;
+                default :
+                    m_is_valid = false;
+                    break;
+            }
+        }
+        return m_is_valid;
+    }
+
+private:
+    // canonical code: number of codes of each length, symbols by code
+    struct Huffman
+    {
+        Huffman()
+            : count(),
+              symbol()
+        { }
+
+        short count[16];
+        short symbol[288];
+    };
+
+    int
+    bits(int need)
+    {
+        auto value = m_bits;
+        for (; m_count < need; m_count += 8) {
+            if (m_pos == m_size) {
+                m_is_valid = false;
+                return 0;
+            }
+            value |= uint32_t(m_data[m_pos++]) << m_count;
+        }
+        m_bits = value >> need;
+        m_count -= need;
+        return static_cast<int>(value & ((1u << need) - 1));
+    }
+
+    int
+    decode(Huffman const& huffman)
+    {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (int length = 1; length < 16 && m_is_valid; ++length) {
+            code |= bits(1);
+            int count = huffman.count[length];
+            if (code - count < first) {
+                return huffman.symbol[index + (code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        m_is_valid = false;
+        return -1;
+    }
+
+    // returns 0 for a complete code, > 0 if incomplete, < 0 if invalid
+    static int
+    build(Huffman& huffman, short const* lengths, int n)
+    {
+        std::fill(huffman.count, huffman.count + 16, short(0));
+        for (int i = 0; i < n; ++i) {
+            ++huffman.count[lengths[i]];
+        }
+        if (huffman.count[0] == n) {
+            return 0;
+        }
+        int left = 1;
+        for (int length = 1; length < 16; ++length) {
+            left = (left << 1) - huffman.count[length];
+            if (left < 0) {
+                return left;
+            }
+        }
+        short offsets[16] = { 0 };
+        for (int length = 1; length < 15; ++length) {
+            offsets[length + 1]
+                    = static_cast<short>(offsets[length]
+                                         + huffman.count[length]);
+        }
+        for (int i = 0; i < n; ++i) {
+            if (lengths[i] != 0) {
+                huffman.symbol[offsets[lengths[i]]++] = static_cast<short>(i);
+            }
+        }
+        return left;
+    }
+
+    void
+    stored()
+    {
+        m_bits = 0;
+        m_count = 0;
+        if (m_size - m_pos < 4) {
+            m_is_valid = false;
+            return;
+        }
+        std::size_t length = m_data[m_pos] | m_data[m_pos + 1] << 8;
+        std::size_t check = m_data[m_pos + 2] | m_data[m_pos + 3] << 8;
+        m_pos += 4;
+        if (length != (~check & 0xffff) || m_size - m_pos < length) {
+            m_is_valid = false;
+            return;
+        }
+        m_out->insert(m_out->end(), m_data + m_pos, m_data + m_pos + length);
+        m_pos += length;
+    }
+
+    void
+    codes(Huffman const& lengths, Huffman const& distances)
+    {
+        static short const length_base[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43,
+            51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static short const length_extra[29] = {
+            0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4,
+            4, 4, 5, 5, 5, 5, 0 };
+        static short const distance_base[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257,
+            385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+            16385, 24577 };
+        static short const distance_extra[30] = {
+            0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9,
+            10, 10, 11, 11, 12, 12, 13, 13 };
+        auto& out = *m_out;
+        for (;;) {
+            auto symbol = decode(lengths);
+            if (symbol < 256) {
+                if (symbol < 0) {
+                    return;
+                }
+                out.push_back(static_cast<char>(symbol));
+                continue;
+            }
+            if (symbol == 256) {
+                return;
+            }
+            symbol -= 257;
+            if (symbol >= 29) {
+                m_is_valid = false;
+                return;
+            }
+            auto length = std::size_t(length_base[symbol]
+                                      + bits(length_extra[symbol]));
+            symbol = decode(distances);
+            if (symbol < 0 || symbol >= 30) {
+                m_is_valid = false;
+                return;
+            }
+            auto distance = std::size_t(distance_base[symbol]
+                                        + bits(distance_extra[symbol]));
+            if (!m_is_valid || distance > out.size()) {
+                m_is_valid = false;
+                return;
+            }
+            // the source may overlap the bytes being appended
+            for (auto from = out.size() - distance; length != 0; --length) {
+                out.push_back(out[from++]);
+            }
+        }
+    }
+
+    // codes of fixed Huffman blocks
+    struct Fixed
+    {
+        Fixed()
+            : lengths(),
+              distances()
+        {
+            short values[288];
+            std::fill(values, values + 144, short(8));
+            std::fill(values + 144, values + 256, short(9));
+            std::fill(values + 256, values + 280, short(7));
+            std::fill(values + 280, values + 288, short(8));
+            build(lengths, values, 288);
+            std::fill(values, values + 30, short(5));
+            build(distances, values, 30);
+        }
+
+        Huffman lengths;
+        Huffman distances;
+    };
+
+    void
+    fixed()
+    {
+        // built once, archives are inflated by several threads
+        static Fixed const tables;
+        codes(tables.lengths, tables.distances);
+    }
+
+    void
+    dynamic()
+    {
+        static short const order[19] = {
+            16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        auto const literals = bits(5) + 257;
+        auto const count = literals + bits(5) + 1;
+        auto const codes_count = bits(4) + 4;
+        if (literals > 286 || count - literals > 30) {
+            m_is_valid = false;
+            return;
+        }
+        short values[320] = { 0 };
+        for (int i = 0; i < codes_count; ++i) {
+            values[order[i]] = static_cast<short>(bits(3));
+        }
+        Huffman lengths;
+        Huffman distances;
+        if (build(lengths, values, 19) != 0) {
+            m_is_valid = false;
+            return;
+        }
+        for (int index = 0; index < count && m_is_valid; ) {
+            auto symbol = decode(lengths);
+            if (symbol < 16) {
+                values[index++] = static_cast<short>(symbol);
+                continue;
+            }
+            short value = 0;
+            int repeat = 0;
+            if (symbol == 16) {
+                if (index == 0) {
+                    m_is_valid = false;
+                    return;
+                }
+                value = values[index - 1];
+                repeat = 3 + bits(2);
+            } else if (symbol == 17) {
+                repeat = 3 + bits(3);
+            } else {
+                repeat = 11 + bits(7);
+            }
+            if (index + repeat > count) {
+                m_is_valid = false;
+                return;
+            }
+            std::fill(values + index, values + index + repeat, value);
+            index += repeat;
+        }
+        // incomplete codes are only allowed for a single length
+        auto error = build(lengths, values, literals);
+        if (!m_is_valid || values[256] == 0 || error < 0
+                || (error > 0 && literals - lengths.count[0] != 1)) {
+            m_is_valid = false;
+            return;
+        }
+        error = build(distances, values + literals, count - literals);
+        if (error < 0 || (error > 0
+                          && count - literals - distances.count[0] != 1)) {
+            m_is_valid = false;
+            return;
+        }
+        codes(lengths, distances);
+    }
+
+    unsigned char const* m_data;
+    std::size_t m_size;
+    std::size_t m_pos;
+    uint32_t m_bits;
+    int m_count;
+    bool m_is_valid;
+    std::vector<char>* m_out;
+};
+
+// encoder of raw deflate streams (RFC 1951) at the highest compression:
+// long hash chains over the whole window, matches deferred by a byte when
+// the next one is longer, and each block stored, with the fixed codes or
+// with its own codes, whichever is the shortest
+class Deflater
+{
+public:
+    explicit Deflater(std::vector<char>& out)
+        : m_out(out),
+          m_bits(),
+          m_count()
+    { }
+
+    Deflater(Deflater const&) = delete;
+    Deflater& operator =(Deflater const&) = delete;
+
+    void
+    deflate(char const* data, std::size_t size)
+    {
+        auto const in = reinterpret_cast<unsigned char const*>(data);
+        std::size_t const none = std::size_t(-1);
+        std::vector<std::size_t> head(std::size_t(1) << hash_bits, none);
+        std::vector<std::size_t> chain(window, none);
+        auto const insert = [&] (std::size_t pos)
+        {
+            if (pos + 2 < size) {
+                auto& first = head[hash(in + pos)];
+                chain[pos & (window - 1)] = first;
+                first = pos;
+            }
+        };
+        // the longest earlier match of the data at 'pos'
+        auto const find = [&] (std::size_t pos, std::size_t& distance)
+        {
+            std::size_t best = 0;
+            auto const limit = std::min(size - pos, std::size_t(max_length));
+            if (limit < min_length) {
+                return best;
+            }
+            auto candidate = head[hash(in + pos)];
+            for (std::size_t steps = 0; candidate != none && steps < max_chain
+                 && pos - candidate <= window; ++steps) {
+                if (in[candidate + best] == in[pos + best]) {
+                    std::size_t length = 0;
+                    while (length < limit
+                           && in[candidate + length] == in[pos + length]) {
+                        ++length;
+                    }
+                    // short matches far away cost more than the literals
+                    if (length > best && (length > min_length
+                                          || pos - candidate <= 4096)) {
+                        best = length;
+                        distance = pos - candidate;
+                        if (best == limit) {
+                            break;
+                        }
+                    }
+                }
+                auto next = chain[candidate & (window - 1)];
+                if (next == none || next >= candidate) {
+                    break;
+                }
+                candidate = next;
+            }
+            return best < min_length ? 0 : best;
+        };
+        std::vector<Token> tokens;
+        std::size_t begin = 0;
+        std::size_t pending = 0;
+        std::size_t pending_distance = 0;
+        for (std::size_t pos = 0; pos < size; ) {
+            std::size_t distance = 0;
+            auto length = find(pos, distance);
+            insert(pos);
+            if (pending != 0 && length <= pending) {
+                // the match from the previous byte
+                tokens.push_back(Token(pending, pending_distance));
+                for (auto end = pos - 1 + pending; ++pos < end; ) {
+                    insert(pos);
+                }
+                pending = 0;
+            } else {
+                if (pending != 0) {
+                    tokens.push_back(Token(0, in[pos - 1]));
+                }
+                pending = length;
+                pending_distance = distance;
+                if (pending == 0) {
+                    tokens.push_back(Token(0, in[pos]));
+                }
+                ++pos;
+            }
+            if (pending == 0 && tokens.size() >= block_tokens) {
+                block(tokens, in + begin, pos - begin, false);
+                tokens.clear();
+                begin = pos;
+            }
+        }
+        block(tokens, in + begin, size - begin, true);
+        if (m_count != 0) {
+            m_out.push_back(static_cast<char>(m_bits));
+        }
+    }
+
+private:
+    // a literal byte if 'length' is 0, a match otherwise
+    struct Token
+    {
+        Token(std::size_t length_, std::size_t value_)
+            : length(static_cast<uint16_t>(length_)),
+              value(static_cast<uint16_t>(value_))
+        { }
+
+        uint16_t length;
+        uint16_t value;
+    };
+
+    static std::size_t constexpr window = 32768;
+    static std::size_t constexpr hash_bits = 15;
+    static std::size_t constexpr min_length = 3;
+    static std::size_t constexpr max_length = 258;
+    static std::size_t constexpr max_chain = 4096;
+    static std::size_t constexpr block_tokens = 1 << 16;
+
+    static std::size_t
+    hash(unsigned char const* p)
+    {
+        auto value = uint32_t(p[0]) << 16 | uint32_t(p[1]) << 8 | p[2];
+        return (value * 2654435761u) >> (32 - hash_bits);
+    }
+
+    static int const*
+    length_table()
+    {
+        static int const base[29] = {
+            3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43,
+            51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        return base;
+    }
+
+    static int const*
+    distance_table()
+    {
+        static int const base[30] = {
+            1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257,
+            385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289,
+            16385, 24577 };
+        return base;
+    }
+
+    static int
+    length_extra(int code)
+    {
+        return code < 8 || code == 28 ? 0 : (code - 4) / 4;
+    }
+
+    static int
+    distance_extra(int code)
+    {
+        return code < 4 ? 0 : (code - 2) / 2;
+    }
+
+    // the code of a length or a distance, among 'count' bases
+    static int
+    code_of(int value, int const* base, int count)
+    {
+        auto code = count - 1;
+        while (base[code] > value) {
+            --code;
+        }
+        return code;
+    }
+
+    // lengths of a Huffman code for 'freqs', limited to 'limit' bits: the
+    // longest codes are shortened and the code completed again by
+    // lengthening shorter ones, from the least frequent symbols on
+    static std::vector<int>
+    lengths(std::vector<std::size_t> const& freqs, int limit)
+    {
+        std::vector<int> res(freqs.size());
+        std::vector<std::size_t> symbols;
+        for (std::size_t i = 0; i < freqs.size(); ++i) {
+            if (freqs[i] != 0) {
+                symbols.push_back(i);
+            }
+        }
+        if (symbols.size() < 2) {
+            for (auto symbol : symbols) {
+                res[symbol] = 1;
+            }
+            return res;
+        }
+        // the tree, leaves first, each node after its children
+        std::vector<std::size_t> parents(symbols.size() * 2 - 1);
+        typedef std::pair<std::size_t, std::size_t> Node;
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node> > queue;
+        for (std::size_t i = 0; i < symbols.size(); ++i) {
+            queue.push(Node(freqs[symbols[i]], i));
+        }
+        for (auto next = symbols.size(); queue.size() > 1; ++next) {
+            auto first = queue.top();
+            queue.pop();
+            auto second = queue.top();
+            queue.pop();
+            parents[first.second] = next;
+            parents[second.second] = next;
+            queue.push(Node(first.first + second.first, next));
+        }
+        std::vector<int> depths(parents.size());
+        std::vector<std::size_t> counts(std::size_t(limit) + 1);
+        for (auto i = parents.size() - 1; i-- > 0; ) {
+            depths[i] = depths[parents[i]] + 1;
+        }
+        for (std::size_t i = 0; i < symbols.size(); ++i) {
+            ++counts[std::size_t(std::min(depths[i], limit))];
+        }
+        std::size_t total = 0;
+        for (int i = 1; i <= limit; ++i) {
+            total += counts[std::size_t(i)] << (limit - i);
+        }
+        for (; total > std::size_t(1) << limit; --total) {
+            --counts[std::size_t(limit)];
+            for (auto i = std::size_t(limit) - 1; i > 0; --i) {
+                if (counts[i] != 0) {
+                    --counts[i];
+                    counts[i + 1] += 2;
+                    break;
+                }
+            }
+        }
+        std::stable_sort(symbols.begin(), symbols.end(),
+                         [&freqs] (std::size_t lhs, std::size_t rhs)
+        { return freqs[lhs] > freqs[rhs]; });
+        std::size_t index = 0;
+        for (int length = 1; length <= limit; ++length) {
+            for (auto n = counts[std::size_t(length)]; n != 0; --n) {
+                res[symbols[index++]] = length;
+            }
+        }
+        return res;
+    }
+
+    // canonical codes of 'lengths', bit-reversed for the output order
+    static std::vector<uint32_t>
+    codes(std::vector<int> const& lengths)
+    {
+        int counts[16] = { 0 };
+        for (auto length : lengths) {
+            ++counts[length];
+        }
+        counts[0] = 0;
+        uint32_t next[16] = { 0 };
+        for (int length = 1; length < 16; ++length) {
+            next[length] = (next[length - 1] + uint32_t(counts[length - 1]))
+                    << 1;
+        }
+        std::vector<uint32_t> res(lengths.size());
+        for (std::size_t i = 0; i < lengths.size(); ++i) {
+            auto const length = lengths[i];
+            if (length != 0) {
+                auto code = next[length]++;
+                for (int j = 0; j < length; ++j) {
+                    res[i] = res[i] << 1 | ((code >> j) & 1);
+                }
+            }
+        }
+        return res;
+    }
+
+    void
+    put(uint32_t value, int count)
+    {
+        m_bits |= uint64_t(value) << m_count;
+        for (m_count += count; m_count >= 8; m_count -= 8) {
+            m_out.push_back(static_cast<char>(m_bits));
+            m_bits >>= 8;
+        }
+    }
+
+    // run-length encoded code lengths of a dynamic block header, as
+    // (symbol, extra bits) pairs
+    static std::vector<std::pair<int, int> >
+    runs(std::vector<int> const& lengths)
+    {
+        std::vector<std::pair<int, int> > res;
+        for (std::size_t i = 0; i < lengths.size(); ) {
+            auto const length = lengths[i];
+            auto end = i + 1;
+            while (end < lengths.size() && lengths[end] == length) {
+                ++end;
+            }
+            auto count = int(end - i);
+            i = end;
+            if (length == 0) {
+                for (; count >= 11; count -= std::min(count, 138)) {
+                    res.push_back(std::make_pair(18,
+                                                 std::min(count, 138) - 11));
+                }
+                if (count >= 3) {
+                    res.push_back(std::make_pair(17, count - 3));
+                    count = 0;
+                }
+            } else {
+                res.push_back(std::make_pair(length, 0));
+                for (--count; count >= 3; count -= std::min(count, 6)) {
+                    res.push_back(std::make_pair(16, std::min(count, 6) - 3));
+                }
+            }
+            for (; count != 0; --count) {
+                res.push_back(std::make_pair(length, 0));
+            }
+        }
+        return res;
+    }
+
+    void
+    block(std::vector<Token> const& tokens, unsigned char const* data,
+          std::size_t size, bool is_last)
+    {
+        std::vector<std::size_t> literal_freqs(286);
+        std::vector<std::size_t> distance_freqs(30);
+        literal_freqs[256] = 1;
+        for (auto const& token : tokens) {
+            if (token.length == 0) {
+                ++literal_freqs[token.value];
+            } else {
+                ++literal_freqs[std::size_t(257 + code_of(token.length,
+                                                          length_table(),
+                                                          29))];
+                ++distance_freqs[std::size_t(code_of(token.value,
+                                                     distance_table(), 30))];
+            }
+        }
+        auto literal_lengths = lengths(literal_freqs, 15);
+        auto distance_lengths = lengths(distance_freqs, 15);
+        // a block of literals still needs one distance code
+        if (std::count(distance_lengths.begin(), distance_lengths.end(), 0)
+                == 30) {
+            distance_lengths[0] = 1;
+        }
+        std::vector<int> fixed_literals(286, 8);
+        std::fill(fixed_literals.begin() + 144, fixed_literals.begin() + 256,
+                  9);
+        std::fill(fixed_literals.begin() + 256, fixed_literals.begin() + 280,
+                  7);
+        std::vector<int> const fixed_distances(30, 5);
+        auto const cost = [&] (std::vector<int> const& literals,
+                               std::vector<int> const& distances)
+        {
+            std::size_t res = 0;
+            for (std::size_t i = 0; i < 286; ++i) {
+                res += literal_freqs[i] * std::size_t(
+                            literals[i] + (i > 256 ? length_extra(int(i - 257))
+                                                   : 0));
+            }
+            for (std::size_t i = 0; i < 30; ++i) {
+                res += distance_freqs[i] * std::size_t(
+                            distances[i] + distance_extra(int(i)));
+            }
+            return res;
+        };
+        // the header of the block with its own codes
+        auto literal_count = std::size_t(286);
+        while (literal_count > 257
+               && literal_lengths[literal_count - 1] == 0) {
+            --literal_count;
+        }
+        auto distance_count = std::size_t(30);
+        while (distance_count > 1
+               && distance_lengths[distance_count - 1] == 0) {
+            --distance_count;
+        }
+        std::vector<int> all(literal_lengths.begin(),
+                             literal_lengths.begin()
+                             + std::ptrdiff_t(literal_count));
+        all.insert(all.end(), distance_lengths.begin(),
+                   distance_lengths.begin() + std::ptrdiff_t(distance_count));
+        auto const header = runs(all);
+        std::vector<std::size_t> header_freqs(19);
+        for (auto const& run : header) {
+            ++header_freqs[std::size_t(run.first)];
+        }
+        auto const header_lengths = lengths(header_freqs, 7);
+        static int const order[19] = {
+            16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        std::size_t order_count = 19;
+        while (order_count > 4
+               && header_lengths[std::size_t(order[order_count - 1])] == 0) {
+            --order_count;
+        }
+        std::size_t dynamic_cost = 14 + 3 * order_count
+                + cost(literal_lengths, distance_lengths);
+        for (auto const& run : header) {
+            dynamic_cost += std::size_t(header_lengths[std::size_t(run.first)]);
+            dynamic_cost += run.first == 16 ? 2 : run.first == 17 ? 3
+                                                : run.first == 18 ? 7 : 0;
+        }
+        auto const fixed_cost = cost(fixed_literals, fixed_distances);
+        auto const stored_cost = (size / 65535 + 1) * 40 + size * 8;
+        auto const last = uint32_t(is_last);
+        if (stored_cost <= std::min(fixed_cost, dynamic_cost) + 3) {
+            for (std::size_t pos = 0; pos == 0 || pos < size; ) {
+                auto count = std::min<std::size_t>(size - pos, 65535);
+                pos += count;
+                put(pos == size ? last : 0, 1);
+                put(0, 2);
+                put(0, (8 - m_count) & 7);
+                put(uint32_t(count), 16);
+                put(uint32_t(~count & 0xffff), 16);
+                for (auto i = pos - count; i < pos; ++i) {
+                    put(data[i], 8);
+                }
+            }
+            return;
+        }
+        if (fixed_cost <= dynamic_cost) {
+            put(last, 1);
+            put(1, 2);
+            literal_lengths = fixed_literals;
+            distance_lengths = fixed_distances;
+        } else {
+            put(last, 1);
+            put(2, 2);
+            put(uint32_t(literal_count - 257), 5);
+            put(uint32_t(distance_count - 1), 5);
+            put(uint32_t(order_count - 4), 4);
+            for (std::size_t i = 0; i < order_count; ++i) {
+                put(uint32_t(header_lengths[std::size_t(order[i])]), 3);
+            }
+            auto const header_codes = codes(header_lengths);
+            for (auto const& run : header) {
+                auto const symbol = std::size_t(run.first);
+                put(header_codes[symbol], header_lengths[symbol]);
+                if (run.first >= 16) {
+                    put(uint32_t(run.second),
+                        run.first == 16 ? 2 : run.first == 17 ? 3 : 7);
+                }
+            }
+        }
+        auto const literal_codes = codes(literal_lengths);
+        auto const distance_codes = codes(distance_lengths);
+        for (auto const& token : tokens) {
+            if (token.length == 0) {
+                put(literal_codes[token.value], literal_lengths[token.value]);
+                continue;
+            }
+            auto code = code_of(token.length, length_table(), 29);
+            auto symbol = std::size_t(257 + code);
+            put(literal_codes[symbol], literal_lengths[symbol]);
+            put(uint32_t(token.length - length_table()[code]),
+                length_extra(code));
+            code = code_of(token.value, distance_table(), 30);
+            put(distance_codes[std::size_t(code)],
+                distance_lengths[std::size_t(code)]);
+            put(uint32_t(token.value - distance_table()[code]),
+                distance_extra(code));
+        }
+        put(literal_codes[256], literal_lengths[256]);
+    }
+
+    std::vector<char>& m_out;
+    uint64_t m_bits;
+    int m_count;
+};
+
+// gzip member (RFC 1952) without a name or a time, so that it only depends
+// on the data
+inline bool
+_gzip(std::vector<char> const& in, std::vector<char>& out)
+{
+    unsigned char const header[] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 2, 255 };
+    out.assign(header, header + sizeof(header));
+    Deflater(out).deflate(in.data(), in.size());
+    auto const crc = _crc32(in.data(), in.size());
+    auto const size = uint32_t(in.size());
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>(crc >> shift));
+    }
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>(size >> shift));
+    }
+    return true;
+}
+
+inline uint64_t
+_get(char const* data, std::size_t size)
+{
+    uint64_t res = 0;
+    for (std::size_t i = size; i-- > 0; ) {
+        res = res << 8 | static_cast<unsigned char>(data[i]);
+    }
+    return res;
+}
+
+// numeric tar header field: octal text or base-256 if the high bit is set
+inline uint64_t
+_tar_number(char const* field, std::size_t size)
+{
+    uint64_t res = 0;
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        for (std::size_t i = 1; i < size; ++i) {
+            res = res << 8 | static_cast<unsigned char>(field[i]);
+        }
+        return res;
+    }
+    for (std::size_t i = 0; i < size && field[i]; ++i) {
+        if (field[i] >= '0' && field[i] <= '7') {
+            res = res << 3 | uint64_t(field[i] - '0');
+        }
+    }
+    return res;
+}
+
+// lists the regular files of a ustar, GNU or pax tar archive
+inline bool
+_read_tar(std::string const& path, std::vector<Member>& members)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string long_name;
+    uint64_t long_size = 0;
+    char header[512];
+    for (uint64_t offset = 0; in.seekg(std::streamoff(offset))
+         && in.read(header, sizeof(header)); ) {
+        if (std::all_of(header, header + sizeof(header),
+                        [] (char c) { return c == '\0'; })) {
+            return true;
+        }
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < sizeof(header); ++i) {
+            sum += i >= 148 && i < 156 ? uint64_t(' ')
+                                       : static_cast<unsigned char>(header[i]);
+        }
+        if (sum != _tar_number(header + 148, 8)) {
+            return false;
+        }
+        auto size = _tar_number(header + 124, 12);
+        auto const type = header[156];
+        offset += sizeof(header);
+        if (type == 'L' || type == 'x') {
+            std::string text(static_cast<std::size_t>(size), '\0');
+            if (!in.read(&text[0], std::streamsize(size))) {
+                return false;
+            }
+            if (type == 'L') {
+                long_name = text.c_str();
+            }
+            // pax records: "<length> <key>=<value>\n"
+            for (std::size_t pos = 0; type == 'x' && pos < text.size(); ) {
+                auto length = std::strtoull(text.c_str() + pos, nullptr, 10);
+                auto space = text.find(' ', pos);
+                if (length == 0 || space == std::string::npos
+                        || pos + length > text.size()) {
+                    break;
+                }
+                auto const record = text.substr(space + 1,
+                                                pos + length - space - 2);
+                if (record.compare(0, 5, "path=") == 0) {
+                    long_name = record.substr(5);
+                } else if (record.compare(0, 5, "size=") == 0) {
+                    long_size = std::strtoull(record.c_str() + 5, nullptr, 10);
+                }
+                pos += length;
+            }
+        } else if (type == '0' || type == '\0' || type == '7') {
+            Member member;
+            if (!long_name.empty()) {
+                member.name = long_name;
+            } else {
+                member.name.assign(header + 345,
+                                   std::find(header + 345, header + 500, '\0'));
+                if (!member.name.empty()) {
+                    member.name += '/';
+                }
+                member.name.append(header,
+                                   std::find(header, header + 100, '\0'));
+            }
+            if (long_size != 0) {
+                size = long_size;
+            }
+            member.offset = offset;
+            member.size = size;
+            member.packed = size;
+            members.push_back(member);
+        }
+        if (type != 'L' && type != 'x') {
+            long_name.clear();
+            long_size = 0;
+        }
+        offset += (size + 511) / 512 * 512;
+    }
+    // archives may end without the zero blocks
+    return in.eof();
+}
+
+// lists the stored and deflated files of a zip (or zip64) archive
+inline bool
+_read_zip(std::string const& path, std::vector<Member>& members)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    auto const file_size = static_cast<uint64_t>(in.tellg());
+    // end of central directory record, followed by a comment of up to 64 KiB
+    auto const tail_size = std::min<uint64_t>(file_size, 22 + 0xffff + 20);
+    std::vector<char> tail(static_cast<std::size_t>(tail_size));
+    in.seekg(std::streamoff(file_size - tail_size));
+    if (!in.read(tail.data(), std::streamsize(tail.size()))) {
+        return false;
+    }
+    auto end = tail.size();
+    for (auto i = tail.size() < 22 ? 0 : tail.size() - 22 + 1; i-- > 0; ) {
+        if (_get(tail.data() + i, 4) == 0x06054b50) {
+            end = i;
+            break;
+        }
+    }
+    if (end == tail.size()) {
+        return false;
+    }
+    auto count = _get(tail.data() + end + 10, 2);
+    auto directory_size = _get(tail.data() + end + 12, 4);
+    auto directory = _get(tail.data() + end + 16, 4);
+    if ((count == 0xffff || directory == 0xffffffff) && end >= 20
+            && _get(tail.data() + end - 20, 4) == 0x07064b50) {
+        char record[56];
+        in.seekg(std::streamoff(_get(tail.data() + end - 12, 8)));
+        if (!in.read(record, sizeof(record))
+                || _get(record, 4) != 0x06064b50) {
+            return false;
+        }
+        count = _get(record + 32, 8);
+        directory_size = _get(record + 40, 8);
+        directory = _get(record + 48, 8);
+    }
+    if (directory + directory_size > file_size) {
+        return false;
+    }
+    std::vector<char> entries(static_cast<std::size_t>(directory_size));
+    in.seekg(std::streamoff(directory));
+    if (!in.read(entries.data(), std::streamsize(entries.size()))) {
+        return false;
+    }
+    std::size_t pos = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (entries.size() - pos < 46
+                || _get(entries.data() + pos, 4) != 0x02014b50) {
+            return false;
+        }
+        auto const entry = entries.data() + pos;
+        auto const flags = _get(entry + 8, 2);
+        Member member;
+        member.method = static_cast<unsigned>(_get(entry + 10, 2));
+        member.packed = _get(entry + 20, 4);
+        member.size = _get(entry + 24, 4);
+        auto const name_size = static_cast<std::size_t>(_get(entry + 28, 2));
+        auto const extra_size = static_cast<std::size_t>(_get(entry + 30, 2));
+        auto const next = pos + 46 + name_size + extra_size
+                + static_cast<std::size_t>(_get(entry + 32, 2));
+        auto local = _get(entry + 42, 4);
+        if (next > entries.size()) {
+            return false;
+        }
+        member.name.assign(entry + 46, name_size);
+        // zip64 values replace the 32-bit fields that are all ones
+        for (auto extra = entry + 46 + name_size;
+             extra + 4 <= entry + 46 + name_size + extra_size; ) {
+            auto const id = _get(extra, 2);
+            auto const size = static_cast<std::size_t>(_get(extra + 2, 2));
+            auto field = extra + 4;
+            if (id == 1) {
+                for (auto value : { &member.size, &member.packed, &local }) {
+                    if (*value == 0xffffffff && field + 8 <= extra + 4 + size) {
+                        *value = _get(field, 8);
+                        field += 8;
+                    }
+                }
+            }
+            extra += 4 + size;
+        }
+        pos = next;
+        if (member.name.empty() || member.name.back() == '/') {
+            continue;
+        }
+        if ((flags & 1) || (member.method != 0 && member.method != 8)) {
+            std::cout << "[WARN] Entry '" << member.name << "' of '" << path
+                      << "' is " << ((flags & 1) ? "encrypted" : "compressed "
+                                     "with an unsupported method")
+                      << " and is ignored" << std::endl;
+            continue;
+        }
+        char header[30];
+        in.seekg(std::streamoff(local));
+        if (!in.read(header, sizeof(header))
+                || _get(header, 4) != 0x04034b50) {
+            return false;
+        }
+        member.offset = local + sizeof(header) + _get(header + 26, 2)
+                + _get(header + 28, 2);
+        members.push_back(member);
+    }
+    return true;
+}
+
+inline bool
+_is_archive(std::string const& path)
+{
+    auto const upper = _to_upper(path);
+    return _ends_with(upper, ".TAR") || _ends_with(upper, ".ZIP");
+}
+
+// lists the files of a tar or zip archive sorted by name, where they are
+// in the archive and how they are stored
+inline bool
+_read_archive(std::string const& path, std::vector<Member>& members)
+{
+    auto is_read = _ends_with(_to_upper(path), ".ZIP")
+            ? _read_zip(path, members) : _read_tar(path, members);
+    if (!is_read) {
+        std::cerr << "[FAIL] Can't read archive '" << path << "'"
+                  << std::endl;
+        return false;
+    }
+    for (auto& member : members) {
+        while (member.name.compare(0, 2, "./") == 0) {
+            member.name.erase(0, 2);
+        }
+    }
+    std::sort(members.begin(), members.end(),
+              [] (Member const& lhs, Member const& rhs)
+    { return lhs.name < rhs.name; });
+    return true;
+}
+
+inline std::size_t
+_hardware_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// calls 'func' for 0 .. count - 1 on up to 'threads' threads
+inline void
+_parallel_for(std::size_t count, std::size_t threads,
+              std::function<void(std::size_t)> const& func)
+{
+    std::atomic<std::size_t> next(0);
+    auto const work = [&] ()
+    {
+        for (auto i = next++; i < count; i = next++) {
+            func(i);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < std::min(count, threads); ++i) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+// lists the files below each root at most its depth directories deep as
+// sorted '/' separated relative paths, into the matching element of
+// 'files'; the directories of all the roots are walked by one pool
+inline bool
+_walk_directories(std::vector<std::pair<std::string, std::size_t> > const&
+                  roots, std::vector<std::vector<std::string> >& files)
+{
+    struct Directory
+    {
+        std::size_t root;
+        std::string path;
+        std::size_t depth;
+    };
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<Directory> pending;
+    for (std::size_t i = 0; i < roots.size(); ++i) {
+        pending.push_back(Directory{ i, std::string(), 0 });
+    }
+    files.assign(roots.size(), std::vector<std::string>());
+    std::size_t busy = 0;
+    bool res = true;
+    auto const work = [&] ()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            condition.wait(lock, [&] { return !pending.empty() || busy == 0; });
+            if (pending.empty()) {
+                return;
+            }
+            auto const dir = pending.back();
+            pending.pop_back();
+            ++busy;
+            lock.unlock();
+            std::vector<std::string> names;
+            std::vector<std::string> subdirs;
+            auto const& root = roots[dir.root].first;
+            auto const path = dir.path.empty() ? root : root + "/" + dir.path;
+            auto is_listed = _list_directory(path, names, subdirs);
+            lock.lock();
+            --busy;
+            if (!is_listed) {
+                std::cerr << "[FAIL] Can't list directory '" << path << "'"
+                          << std::endl;
+                res = false;
+            }
+            auto const prefix = dir.path.empty() ? dir.path : dir.path + "/";
+            for (auto const& name : names) {
+                files[dir.root].push_back(prefix + name);
+            }
+            if (dir.depth < roots[dir.root].second) {
+                for (auto const& name : subdirs) {
+                    pending.push_back(Directory{ dir.root, prefix + name,
+                                                 dir.depth + 1 });
+                }
+            }
+            condition.notify_all();
+        }
+    };
+    if (!roots.empty()) {
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < _hardware_threads(); ++i) {
+            threads.emplace_back(work);
+        }
+        work();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    for (auto& list : files) {
+        std::sort(list.begin(), list.end());
+    }
+    return res;
+}
+
+// contents of the standard input ('-' as a file), read once on first use
+inline std::vector<char> const&
+_stdin_data()
+{
+    static std::vector<char> const data = [] ()
+    {
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif  // _WIN32
+        std::vector<char> res;
+        char buffer[1 << 16];
+        for (std::size_t count;
+             (count = std::fread(buffer, 1, sizeof(buffer), stdin)) != 0; ) {
+            res.insert(res.end(), buffer, buffer + count);
+        }
+        return res;
+    }();
+    return data;
+}
+
+// the directory to walk for a directory or pattern input, the pattern its
+// files have to match relative to it and how deep it is walked; false for
+// other inputs
+inline bool
+_input_root(Input const& input,
+            std::string& root, std::string& pattern, std::size_t& depth)
+{
+    // an existing file is taken as is, even with '[' in its name
+    auto const wildcard = _is_path_exists(input.file)
+            ? std::string::npos : input.file.find_first_of("*?[");
+    if (wildcard == std::string::npos && !_is_directory_exists(input.file)) {
+        return false;
+    }
+    root = input.file;
+    pattern = "**";
+    if (wildcard != std::string::npos) {
+        auto const slash = input.file.find_last_of("/\\", wildcard);
+        root = slash == std::string::npos ? "." : input.file.substr(0, slash);
+        pattern = input.file.substr(slash + 1);
+    }
+    while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) {
+        root.pop_back();
+    }
+    // without '**' there is no need to go deeper than the pattern
+    depth = std::size_t(std::count(pattern.begin(), pattern.end(), '/'));
+    if (pattern.find("**") != std::string::npos) {
+        depth = std::size_t(-1);
+    }
+    return true;
+}
+
+// replaces directories and patterns (with '*', '?', '[...]' or '**') by
+// the files they match; the alias is a prefix for their paths relative to
+// the directory or the part of the pattern before the first wildcard.
+// An existing path is never a pattern. A .tar or .zip archive with an empty
+// or '/' terminated alias is replaced by the files in it, otherwise it is a
+// resource itself
+inline bool
+_expand_inputs(std::vector<Input>& inputs)
+{
+    // the directories to walk, with the pattern each input matches and the
+    // input it belongs to
+    std::vector<std::pair<std::string, std::size_t> > roots;
+    std::vector<std::string> patterns;
+    std::vector<std::size_t> walked(inputs.size(), std::size_t(-1));
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        std::string root;
+        std::string pattern;
+        std::size_t depth = 0;
+        if (!_input_root(inputs[i], root, pattern, depth)) {
+            continue;
+        }
+        walked[i] = roots.size();
+        roots.push_back(std::make_pair(root, depth));
+        patterns.push_back(pattern);
+    }
+    std::vector<std::vector<std::string> > listed;
+    bool is_valid = _walk_directories(roots, listed);
+
+    std::vector<Input> res;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        auto const& input = inputs[i];
+        auto const is_prefix = input.alias.empty() || input.alias.back() == '/';
+        if (walked[i] == std::size_t(-1) && is_prefix
+                && _is_archive(input.file)) {
+            std::vector<Member> members;
+            if (!_read_archive(input.file, members)) {
+                is_valid = false;
+                continue;
+            }
+            for (auto const& member : members) {
+                Input expanded = input;
+                expanded.alias = input.alias + member.name;
+                expanded.member = member;
+                res.push_back(expanded);
+            }
+            continue;
+        }
+        if (walked[i] == std::size_t(-1)) {
+            if (input.alias.empty()) {
+                std::cerr << "[FAIL] Resource '" << input.file
+                          << "' has an empty alias" << std::endl;
+                is_valid = false;
+                continue;
+            }
+            res.push_back(input);
+            continue;
+        }
+        auto const& root = roots[walked[i]].first;
+        auto const& pattern = patterns[walked[i]];
+        auto prefix = input.alias;
+        if (!prefix.empty() && prefix.back() != '/') {
+            prefix += '/';
+        }
+        auto const count = res.size();
+        for (auto const& file : listed[walked[i]]) {
+            if (!_glob_match(pattern.c_str(), file.c_str())) {
+                continue;
+            }
+            Input expanded = input;
+            expanded.file = root + "/" + file;
+            expanded.alias = prefix + file;
+            res.push_back(expanded);
+        }
+        if (res.size() == count) {
+            std::cout << "[WARN] No files match '" << input.file << "'"
+                      << std::endl;
+        }
+    }
+    inputs.swap(res);
+    return is_valid;
+}
+
+// the directories walked for the directory and pattern inputs among
+// 'inputs', where files can come and go
+inline std::vector<std::string>
+_walked_directories(std::vector<Input> const& inputs)
+{
+    std::vector<std::pair<std::string, std::size_t> > pending;
+    for (auto const& input : inputs) {
+        std::string root;
+        std::string pattern;
+        std::size_t depth = 0;
+        if (_input_root(input, root, pattern, depth)) {
+            pending.push_back(std::make_pair(root, depth));
+        }
+    }
+    std::vector<std::string> res;
+    while (!pending.empty()) {
+        auto const dir = pending.back();
+        pending.pop_back();
+        res.push_back(dir.first);
+        std::vector<std::string> files;
+        std::vector<std::string> subdirs;
+        if (dir.second == 0
+                || !_list_directory(dir.first, files, subdirs)) {
+            continue;
+        }
+        for (auto const& name : subdirs) {
+            pending.push_back(std::make_pair(dir.first + "/" + name,
+                                             dir.second - 1));
+        }
+    }
+    return res;
+}
+
+// expands the archives among 'changed' again, as their members move when
+// they are rewritten; the members are kept as they were if an archive can't
+// be read (yet), and false is returned
+inline bool
+_update_archives(std::vector<Input>& inputs,
+                 std::set<std::string> const& changed)
+{
+    bool res = true;
+    std::vector<Input> updated;
+    std::set<std::pair<std::string, std::string> > expanded;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        auto const& input = inputs[i];
+        auto const& name = input.member.name;
+        if (name.empty() || changed.count(_absolute_path(input.file)) == 0) {
+            updated.push_back(input);
+            continue;
+        }
+        // the members of an archive are next to each other and share the
+        // alias prefix of the input they were expanded from
+        auto const prefix = input.alias.substr(0, input.alias.size()
+                                                  - name.size());
+        if (!expanded.insert(std::make_pair(input.file, prefix)).second) {
+            continue;
+        }
+        std::vector<Input> members(1, input);
+        members[0].alias = prefix;
+        members[0].member = Member();
+        auto const last = std::find_if(
+                    inputs.begin() + std::ptrdiff_t(i), inputs.end(),
+                    [&] (Input const& other)
+        {
+            return other.file != input.file || other.member.name.empty()
+                    || other.alias.compare(0, prefix.size(), prefix) != 0;
+        });
+        if (_expand_inputs(members)) {
+            updated.insert(updated.end(), members.begin(), members.end());
+        } else {
+            updated.insert(updated.end(), inputs.begin() + std::ptrdiff_t(i),
+                           last);
+            res = false;
+        }
+    }
+    inputs.swap(updated);
+    return res;
+}
+
+inline std::vector<Resource>
+_load_resources(std::vector<Input> const& inputs,
+                std::vector<Resource> const& cache = std::vector<Resource>(),
+                std::set<std::string> const& changed = std::set<std::string>())
+{
+    std::vector<Resource> resources;
+    std::set<std::string> aliases;
+    std::map<std::pair<std::string, std::string>, Resource const*> cached;
+    for (auto const& res : cache) {
+        cached.insert(std::make_pair(std::make_pair(res.file, res.member.name),
+                                     &res));
+    }
+    for (auto const& input : inputs) {
+        if (!aliases.insert(input.alias).second) {
+            std::cout << "[WARN] Duplicate alias '" << input.alias
+                      << "' for file '" << input.file << "' is ignored"
+                      << std::endl;
+            continue;
+        }
+        auto const path = input.file == "-" ? input.file
+                                            : _absolute_path(input.file);
+        auto it = cached.find(std::make_pair(path, input.member.name));
+        if (it != cached.end() && changed.count(path) == 0
+                && it->second->type == input.type) {
+            resources.push_back(*it->second);
+            resources.back().alias = input.alias;
+            resources.back().preferred = input.mode;
+            continue;
+        }
+        // only the size for now, the data is read by the modes that need it
+        Resource res;
+        res.member = input.member;
+        res.size = input.member.size;
+        if (input.file == "-") {
+            res.size = _stdin_data().size();
+        } else if (input.member.name.empty()
+                   && !_file_size(input.file, res.size)) {
+            std::cout << "[FAIL] Can't open file '" << input.file << "'"
+                      << std::endl;
+            continue;
+        }
+        res.file = path;
+        res.alias = input.alias;
+        res.preferred = input.mode;
+        res.type = input.type;
+        resources.push_back(std::move(res));
+    }
+    return resources;
+}
+
+inline bool
+_read_data(Resource& resource)
+{
+    if (resource.data.size() == resource.size) {
+        return true;
+    }
+    if (resource.file == "-") {
+        resource.data = _stdin_data();
+        return true;
+    }
+    auto const& member = resource.member;
+    std::ifstream in(resource.file, std::ios::binary);
+    in.seekg(std::streamoff(member.offset));
+    bool is_read = true;
+    if (member.method == 8) {
+        std::vector<char> packed(static_cast<std::size_t>(member.packed));
+        resource.data.clear();
+        resource.data.reserve(static_cast<std::size_t>(resource.size));
+        is_read = in.read(packed.data(), std::streamsize(packed.size()))
+                && Inflater(packed.data(), packed.size()).inflate(resource.data)
+                && resource.data.size() == resource.size;
+    } else {
+        resource.data.resize(static_cast<std::size_t>(resource.size));
+        is_read = !!in.read(resource.data.data(),
+                            std::streamsize(resource.size));
+    }
+    if (!is_read) {
+        std::cout << "[FAIL] Can't read file '" << resource.file << "'";
+        if (!member.name.empty()) {
+            std::cout << " entry '" << member.name << "'";
+        }
+        std::cout << std::endl;
+        resource.data.clear();
+        return false;
+    }
+    return true;
+}
+
+#if defined(CPP_GENERES_IO_URING)
+// minimal io_uring instance driven through the raw system calls
+class Ring
+{
+public:
+    explicit Ring(unsigned entries)
+        : m_fd(-1),
+          m_rings(MAP_FAILED),
+          m_rings_size(),
+          m_sqes(MAP_FAILED),
+          m_sqes_size(),
+          m_params(),
+          m_tail(),
+          m_submitted()
+    {
+        std::memset(&m_params, 0, sizeof(m_params));
+        m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries,
+                                          &m_params));
+        if (m_fd < 0 || !(m_params.features & IORING_FEAT_SINGLE_MMAP)) {
+            return;
+        }
+        // both rings share one mapping since Linux 5.4
+        m_rings_size = std::max(
+                    m_params.sq_off.array
+                    + m_params.sq_entries * sizeof(unsigned),
+                    m_params.cq_off.cqes
+                    + m_params.cq_entries * sizeof(io_uring_cqe));
+        m_rings = ::mmap(nullptr, m_rings_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+        m_sqes_size = m_params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+        if (is_valid()) {
+            m_tail = m_submitted = *field(m_params.sq_off.tail);
+        }
+    }
+
+    Ring(Ring const&) = delete;
+    Ring& operator =(Ring const&) = delete;
+
+    ~Ring()
+    {
+        if (m_sqes != MAP_FAILED) {
+            ::munmap(m_sqes, m_sqes_size);
+        }
+        if (m_rings != MAP_FAILED) {
+            ::munmap(m_rings, m_rings_size);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool
+    is_valid() const
+    {
+        return m_fd >= 0 && m_rings != MAP_FAILED && m_sqes != MAP_FAILED;
+    }
+
+    unsigned
+    entries() const
+    {
+        return m_params.sq_entries;
+    }
+
+    // returns a cleared submission entry, nullptr if the queue is full
+    io_uring_sqe*
+    next()
+    {
+        auto head = __atomic_load_n(field(m_params.sq_off.head),
+                                    __ATOMIC_ACQUIRE);
+        if (m_tail - head >= m_params.sq_entries) {
+            return nullptr;
+        }
+        auto index = m_tail & *field(m_params.sq_off.ring_mask);
+        field(m_params.sq_off.array)[index] = index;
+        auto sqe = static_cast<io_uring_sqe*>(m_sqes) + index;
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++m_tail;
+        return sqe;
+    }
+
+    // submits the new entries and waits for at least 'count' completions
+    bool
+    submit_and_wait(unsigned count = 1)
+    {
+        __atomic_store_n(field(m_params.sq_off.tail), m_tail,
+                         __ATOMIC_RELEASE);
+        for (;;) {
+            auto res = ::syscall(__NR_io_uring_enter, m_fd,
+                                 m_tail - m_submitted, count,
+                                 count ? IORING_ENTER_GETEVENTS : 0u,
+                                 nullptr, 0);
+            if (res >= 0) {
+                m_submitted += static_cast<unsigned>(res);
+                return true;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                return false;
+            }
+        }
+    }
+
+    // takes the next completion, false if there is none
+    bool
+    pop(io_uring_cqe& cqe)
+    {
+        auto head = *field(m_params.cq_off.head);
+        if (head == __atomic_load_n(field(m_params.cq_off.tail),
+                                    __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+        auto cqes = reinterpret_cast<io_uring_cqe*>(
+                    static_cast<char*>(m_rings) + m_params.cq_off.cqes);
+        cqe = cqes[head & *field(m_params.cq_off.ring_mask)];
+        __atomic_store_n(field(m_params.cq_off.head), head + 1,
+                         __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    unsigned*
+    field(uint32_t offset) const
+    {
+        return reinterpret_cast<unsigned*>(static_cast<char*>(m_rings)
+                                           + offset);
+    }
+
+    int m_fd;
+    void* m_rings;
+    std::size_t m_rings_size;
+    void* m_sqes;
+    std::size_t m_sqes_size;
+    io_uring_params m_params;
+    unsigned m_tail;
+    unsigned m_submitted;
+};
+
+// opens, reads and closes files through io_uring with up to a ring full of
+// operations in flight, returns the resources that couldn't be read this way
+inline std::vector<Resource*>
+_read_files_ring(std::vector<Resource*> const& resources)
+{
+    Ring ring(256);
+    if (!ring.is_valid()) {
+        return resources;
+    }
+    enum { Open, Read, Close };
+    std::vector<int> fds(resources.size(), -1);
+    std::vector<uint64_t> done(resources.size(), 0);
+    std::vector<bool> is_read(resources.size(), false);
+    std::size_t next = 0;
+    std::size_t in_flight = 0;
+    // no more than a queue full of operations is in flight, should the
+    // queue be full anyway its entries are submitted to make room; when
+    // that fails too, the files left are read by the thread pool
+    bool is_full = false;
+    auto const take = [&ring, &is_full] ()
+    {
+        auto sqe = ring.next();
+        if (!sqe && ring.submit_and_wait(0)) {
+            sqe = ring.next();
+        }
+        is_full = is_full || !sqe;
+        return sqe;
+    };
+    // false if the read can't be queued, the file is then closed here
+    auto const submit_read = [&] (std::size_t i)
+    {
+        auto sqe = take();
+        if (!sqe) {
+            ::close(fds[i]);
+            fds[i] = -1;
+            return false;
+        }
+        auto& data = resources[i]->data;
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fds[i];
+        sqe->addr = reinterpret_cast<uintptr_t>(data.data() + done[i]);
+        sqe->len = static_cast<uint32_t>(
+                    std::min<uint64_t>(data.size() - done[i], 1u << 30));
+        sqe->off = done[i];
+        sqe->user_data = i << 2 | Read;
+        return true;
+    };
+    auto const submit_close = [&] (std::size_t i)
+    {
+        auto sqe = take();
+        if (!sqe) {
+            ::close(fds[i]);
+            fds[i] = -1;
+            return false;
+        }
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = fds[i];
+        sqe->user_data = i << 2 | Close;
+        fds[i] = -1;
+        return true;
+    };
+    // every completion frees the slot that its follow-up operation takes
+    while ((next < resources.size() && !is_full) || in_flight != 0) {
+        for (; next < resources.size() && in_flight < ring.entries();
+             ++next, ++in_flight) {
+            auto sqe = take();
+            if (!sqe) {
+                break;
+            }
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = reinterpret_cast<uintptr_t>(
+                        resources[next]->file.c_str());
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = next << 2 | Open;
+        }
+        if (!ring.submit_and_wait()) {
+            break;
+        }
+        io_uring_cqe cqe;
+        while (ring.pop(cqe)) {
+            --in_flight;
+            auto const i = static_cast<std::size_t>(cqe.user_data >> 2);
+            auto const operation = cqe.user_data & 3;
+            if (operation == Close || cqe.res < 0
+                    || (operation == Read && cqe.res == 0)) {
+                if (operation != Close && fds[i] >= 0 && submit_close(i)) {
+                    ++in_flight;
+                }
+                continue;
+            }
+            if (operation == Open) {
+                fds[i] = cqe.res;
+                resources[i]->data.resize(
+                            static_cast<std::size_t>(resources[i]->size));
+            } else {
+                done[i] += static_cast<uint64_t>(cqe.res);
+            }
+            if (done[i] < resources[i]->data.size()) {
+                if (submit_read(i)) {
+                    ++in_flight;
+                }
+            } else {
+                is_read[i] = true;
+                if (submit_close(i)) {
+                    ++in_flight;
+                }
+            }
+        }
+    }
+    std::vector<Resource*> res;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        if (fds[i] >= 0) {
+            ::close(fds[i]);
+        }
+        if (!is_read[i]) {
+            resources[i]->data.clear();
+            res.push_back(resources[i]);
+        }
+    }
+    return res;
+}
+#endif  // CPP_GENERES_IO_URING
+
+// reads the data of many resources at once: through io_uring where the
+// system has it, the rest on a pool of threads so that many small files
+// are in flight at any time
+inline void
+_read_files(std::vector<Resource*> const& resources)
+{
+    // archive entries are read at their offsets, and maybe inflated, and
+    // the standard input is read once
+    std::vector<Resource*> files;
+    std::vector<Resource*> rest;
+    for (auto resource : resources) {
+        auto is_file = resource->member.name.empty()
+                && !_is_in_memory(*resource);
+        (is_file ? files : rest).push_back(resource);
+    }
+#if defined(CPP_GENERES_IO_URING)
+    auto const failed = _read_files_ring(files);
+    rest.insert(rest.end(), failed.begin(), failed.end());
+#else
+    rest.insert(rest.end(), files.begin(), files.end());
+#endif  // CPP_GENERES_IO_URING
+    _parallel_for(rest.size(), 32, [&rest] (std::size_t i)
+    { _read_data(*rest[i]); });
+}
+
+inline std::string
+_temp_directory()
+{
+    for (auto name : { "TMPDIR", "TEMP", "TMP" }) {
+        auto dir = std::getenv(name);
+        if (dir && *dir) {
+            return dir;
+        }
+    }
+    return "/tmp";
+}
+
+// transforms the data of a resource before it is embedded
+typedef std::function<bool (std::vector<char> const& in,
+                            std::vector<char>& out)> Filter;
+
+inline bool
+_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+// drops the whitespace outside of strings
+inline bool
+_minify_json(std::vector<char> const& in, std::vector<char>& out)
+{
+    out.reserve(in.size());
+    bool is_string = false;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        auto c = in[i];
+        if (is_string) {
+            out.push_back(c);
+            if (c == '\\' && i + 1 < in.size()) {
+                out.push_back(in[++i]);
+            } else if (c == '"') {
+                is_string = false;
+            }
+        } else if (!_is_space(c)) {
+            out.push_back(c);
+            is_string = c == '"';
+        }
+    }
+    return !is_string;
+}
+
+// drops comments, the whitespace next to punctuation and the last ';' of
+// blocks, other whitespace becomes a single space
+inline bool
+_minify_css(std::vector<char> const& in, std::vector<char>& out)
+{
+    out.reserve(in.size());
+    auto const is_tight = [] (char c)
+    { return c == '{' || c == '}' || c == ';' || c == ',' || c == '>'; };
+    bool has_space = false;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        auto c = in[i];
+        if (c == '/' && i + 1 < in.size() && in[i + 1] == '*') {
+            auto end = std::search(in.begin() + std::ptrdiff_t(i) + 2,
+                                   in.end(), "*/", "*/" + 2);
+            if (end == in.end()) {
+                return false;
+            }
+            i = static_cast<std::size_t>(end - in.begin()) + 1;
+            has_space = true;
+            continue;
+        }
+        if (_is_space(c)) {
+            has_space = true;
+            continue;
+        }
+        if (has_space && !out.empty() && !is_tight(out.back())
+                && out.back() != ':' && !is_tight(c)) {
+            out.push_back(' ');
+        }
+        has_space = false;
+        if (c == '}' && !out.empty() && out.back() == ';') {
+            out.pop_back();
+        }
+        out.push_back(c);
+        if (c == '"' || c == '\'') {
+            for (++i; i < in.size() && in[i] != c; ++i) {
+                if (in[i] == '\\' && i + 1 < in.size()) {
+                    out.push_back(in[i++]);
+                }
+                out.push_back(in[i]);
+            }
+            if (i == in.size()) {
+                return false;
+            }
+            out.push_back(c);
+        }
+    }
+    return true;
+}
+
+// drops comments and turns runs of whitespace into a single space, except
+// in the contents of pre, textarea, script and style elements and in
+// attribute values
+inline bool
+_minify_html(std::vector<char> const& in, std::vector<char>& out)
+{
+    out.reserve(in.size());
+    auto const starts = [&in] (std::size_t pos, char const* str)
+    {
+        for (; *str; ++str, ++pos) {
+            if (pos == in.size() || std::tolower(
+                        static_cast<unsigned char>(in[pos])) != *str) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool has_space = false;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        auto c = in[i];
+        if (_is_space(c)) {
+            has_space = true;
+            continue;
+        }
+        // conditional comments are kept
+        if (starts(i, "<!--") && !starts(i, "<!--[if")) {
+            auto end = std::search(in.begin() + std::ptrdiff_t(i) + 4,
+                                   in.end(), "-->", "-->" + 3);
+            if (end == in.end()) {
+                return false;
+            }
+            i = static_cast<std::size_t>(end - in.begin()) + 2;
+            continue;
+        }
+        if (has_space && !out.empty()) {
+            out.push_back(' ');
+        }
+        has_space = false;
+        // a tag starts with a name, '/', '!' or '?', other '<' are text
+        auto const next = i + 1 < in.size()
+                ? static_cast<unsigned char>(in[i + 1]) : 0;
+        if (c != '<' || !(std::isalpha(next) || next == '/' || next == '!'
+                          || next == '?')) {
+            out.push_back(c);
+            continue;
+        }
+        std::string verbatim;
+        for (auto name : { "pre", "textarea", "script", "style" }) {
+            auto const length = std::strlen(name);
+            if (starts(i + 1, name) && (i + 1 + length == in.size()
+                                        || !std::isalnum(
+                                            static_cast<unsigned char>(
+                                                in[i + 1 + length])))) {
+                verbatim = name;
+            }
+        }
+        // the tag, with its whitespace collapsed outside of quotes
+        char quote = 0;
+        for (; i < in.size(); ++i) {
+            c = in[i];
+            if (quote == 0 && _is_space(c)) {
+                has_space = true;
+                continue;
+            }
+            if (has_space && c != '>' && c != '=' && out.back() != '<'
+                    && out.back() != '=') {
+                out.push_back(' ');
+            }
+            has_space = false;
+            out.push_back(c);
+            if (quote != 0) {
+                quote = c == quote ? 0 : quote;
+            } else if (c == '"' || c == '\'') {
+                quote = c;
+            } else if (c == '>') {
+                break;
+            }
+        }
+        if (i == in.size()) {
+            return false;
+        }
+        if (!verbatim.empty()) {
+            auto const close = "</" + verbatim;
+            auto end = i + 1;
+            while (end < in.size() && !starts(end, close.c_str())) {
+                ++end;
+            }
+            out.insert(out.end(), in.begin() + std::ptrdiff_t(i) + 1,
+                       in.begin() + std::ptrdiff_t(end));
+            i = end - 1;
+        }
+    }
+    return true;
+}
+
+// drops comments and the whitespace that doesn't separate tokens, keeps
+// preprocessor directives on lines of their own
+inline bool
+_minify_glsl(std::vector<char> const& in, std::vector<char>& out)
+{
+    out.reserve(in.size());
+    auto const is_word = [] (char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_'
+                || c == '.';
+    };
+    auto const is_operator = [] (char c)
+    { return std::strchr("+-*/%<>=!&|^", c) != nullptr && c != '\0'; };
+    bool has_space = false;
+    bool is_directive = false;
+    bool is_line_start = true;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        auto c = in[i];
+        if (c == '/' && i + 1 < in.size() && in[i + 1] == '/') {
+            while (i + 1 < in.size() && in[i + 1] != '\n') {
+                ++i;
+            }
+            continue;
+        }
+        if (c == '/' && i + 1 < in.size() && in[i + 1] == '*') {
+            auto end = std::search(in.begin() + std::ptrdiff_t(i) + 2,
+                                   in.end(), "*/", "*/" + 2);
+            if (end == in.end()) {
+                return false;
+            }
+            i = static_cast<std::size_t>(end - in.begin()) + 1;
+            has_space = true;
+            continue;
+        }
+        if (is_directive && c == '\\' && i + 1 < in.size()
+                && (in[i + 1] == '\n' || in[i + 1] == '\r')) {
+            // line continuation
+            while (i + 1 < in.size() && in[i + 1] != '\n') {
+                ++i;
+            }
+            has_space = true;
+            ++i;
+            continue;
+        }
+        if (c == '\n') {
+            if (is_directive) {
+                out.push_back('\n');
+                is_directive = false;
+                has_space = false;
+            } else {
+                has_space = true;
+            }
+            is_line_start = true;
+            continue;
+        }
+        if (_is_space(c)) {
+            has_space = true;
+            continue;
+        }
+        if (c == '#' && is_line_start) {
+            if (!out.empty() && out.back() != '\n') {
+                out.push_back('\n');
+            }
+            is_directive = true;
+            has_space = false;
+        }
+        is_line_start = false;
+        // directives keep a space wherever there was one, '#define F (x)'
+        // isn't '#define F(x)'
+        if (has_space && !out.empty() && out.back() != '\n'
+                && (is_directive
+                    || (is_word(out.back()) && is_word(c))
+                    || (is_operator(out.back()) && is_operator(c)))) {
+            out.push_back(' ');
+        }
+        has_space = false;
+        out.push_back(c);
+    }
+    if (is_directive) {
+        out.push_back('\n');
+    }
+    return true;
+}
+
+// lone surrogates and values past U+10FFFF become U+FFFD
+inline void
+_append_utf8(std::string& str, uint32_t code)
+{
+    if ((code >= 0xd800 && code < 0xe000) || code > 0x10ffff) {
+        code = 0xfffd;
+    }
+    if (code < 0x80) {
+        str += static_cast<char>(code);
+    } else if (code < 0x800) {
+        str += static_cast<char>(0xc0 | code >> 6);
+        str += static_cast<char>(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        str += static_cast<char>(0xe0 | code >> 12);
+        str += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+        str += static_cast<char>(0x80 | (code & 0x3f));
+    } else {
+        str += static_cast<char>(0xf0 | code >> 18);
+        str += static_cast<char>(0x80 | (code >> 12 & 0x3f));
+        str += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+        str += static_cast<char>(0x80 | (code & 0x3f));
+    }
+}
+
+// converts JSON (RFC 8259) to CBOR (RFC 8949) with definite lengths and
+// the members in their order; integers stay integers, other numbers become
+// the shortest of float32 and float64 that holds them
+class JsonToCbor
+{
+public:
+    JsonToCbor(std::vector<char> const& in, std::vector<char>& out)
+        : m_in(in),
+          m_out(out),
+          m_pos(),
+          m_is_valid(true)
+    { }
+
+    JsonToCbor(JsonToCbor const&) = delete;
+    JsonToCbor& operator =(JsonToCbor const&) = delete;
+
+    bool
+    convert()
+    {
+        m_out.reserve(m_in.size() / 2);
+        value(0);
+        space();
+        return m_is_valid && m_pos == m_in.size();
+    }
+
+private:
+    // the head of an item with major type 'major' and argument 'arg'
+    static std::string
+    head(unsigned major, uint64_t arg)
+    {
+        std::string res;
+        auto type = static_cast<char>(major << 5);
+        if (arg < 24) {
+            res += static_cast<char>(type | static_cast<char>(arg));
+            return res;
+        }
+        std::size_t count = arg < 0x100 ? 1 : arg < 0x10000 ? 2
+                                             : arg < 0x100000000 ? 4 : 8;
+        res += static_cast<char>(type | (count == 1 ? 24 : count == 2 ? 25
+                                                    : count == 4 ? 26 : 27));
+        for (std::size_t i = count; i-- > 0; ) {
+            res += static_cast<char>(arg >> (8 * i));
+        }
+        return res;
+    }
+
+    void
+    append(std::string const& str)
+    {
+        m_out.insert(m_out.end(), str.begin(), str.end());
+    }
+
+    void
+    space()
+    {
+        while (m_pos < m_in.size() && _is_space(m_in[m_pos])) {
+            ++m_pos;
+        }
+    }
+
+    bool
+    take(char c)
+    {
+        space();
+        if (m_pos < m_in.size() && m_in[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool
+    take(char const* word)
+    {
+        auto length = std::strlen(word);
+        if (m_in.size() - m_pos < length
+                || std::memcmp(m_in.data() + m_pos, word, length) != 0) {
+            return false;
+        }
+        m_pos += length;
+        return true;
+    }
+
+    void
+    value(int depth)
+    {
+        space();
+        if (m_pos == m_in.size() || depth > 512) {
+            m_is_valid = false;
+            return;
+        }
+        auto c = m_in[m_pos];
+        if (c == '{' || c == '[') {
+            ++m_pos;
+            auto const close = c == '{' ? '}' : ']';
+            auto const start = m_out.size();
+            uint64_t count = 0;
+            if (!take(close)) {
+                do {
+                    if (c == '{') {
+                        space();
+                        string();
+                        if (!take(':')) {
+                            m_is_valid = false;
+                        }
+                    }
+                    value(depth + 1);
+                    ++count;
+                } while (m_is_valid && take(','));
+                m_is_valid = m_is_valid && take(close);
+            }
+            auto const str = head(c == '{' ? 5 : 4, count);
+            m_out.insert(m_out.begin() + std::ptrdiff_t(start),
+                         str.begin(), str.end());
+        } else if (c == '"') {
+            string();
+        } else if (take("true")) {
+            m_out.push_back(static_cast<char>(0xf5));
+        } else if (take("false")) {
+            m_out.push_back(static_cast<char>(0xf4));
+        } else if (take("null")) {
+            m_out.push_back(static_cast<char>(0xf6));
+        } else {
+            number();
+        }
+    }
+
+    void
+    string()
+    {
+        if (m_pos == m_in.size() || m_in[m_pos] != '"') {
+            m_is_valid = false;
+            return;
+        }
+        std::string res;
+        for (++m_pos; m_pos < m_in.size() && m_in[m_pos] != '"'; ++m_pos) {
+            auto c = m_in[m_pos];
+            if (c != '\\') {
+                res += c;
+                continue;
+            }
+            if (++m_pos == m_in.size()) {
+                break;
+            }
+            c = m_in[m_pos];
+            auto const escapes = std::string("\"\\/bfnrt");
+            auto const values = std::string("\"\\/\b\f\n\r\t");
+            auto index = escapes.find(c);
+            if (index != std::string::npos) {
+                res += values[index];
+                continue;
+            }
+            uint32_t code = 0;
+            if (c != 'u' || !hex(code)) {
+                m_is_valid = false;
+                return;
+            }
+            if (code >= 0xd800 && code < 0xdc00) {
+                // a high surrogate, followed by the low one
+                auto const pos = m_pos;
+                uint32_t low = 0;
+                m_pos += 2;
+                if (m_pos < m_in.size() && m_in[m_pos - 1] == '\\'
+                        && m_in[m_pos] == 'u' && hex(low)
+                        && low >= 0xdc00 && low < 0xe000) {
+                    code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                } else {
+                    m_pos = pos;
+                }
+            }
+            _append_utf8(res, code);
+        }
+        if (m_pos == m_in.size()) {
+            m_is_valid = false;
+            return;
+        }
+        ++m_pos;
+        append(head(3, res.size()));
+        append(res);
+    }
+
+    // four hexadecimal digits after the 'u' at the current position
+    bool
+    hex(uint32_t& code)
+    {
+        if (m_in.size() - m_pos < 5) {
+            return false;
+        }
+        code = 0;
+        for (std::size_t i = 1; i <= 4; ++i) {
+            auto c = static_cast<unsigned char>(m_in[m_pos + i]);
+            if (!std::isxdigit(c)) {
+                return false;
+            }
+            code = code << 4 | static_cast<uint32_t>(
+                        std::isdigit(c) ? c - '0' : std::tolower(c) - 'a' + 10);
+        }
+        m_pos += 4;
+        return true;
+    }
+
+    // a float of 'count' bytes after the initial byte 'initial'
+    void
+    real(unsigned initial, uint64_t bits, std::size_t count)
+    {
+        m_out.push_back(static_cast<char>(initial));
+        for (std::size_t i = count; i-- > 0; ) {
+            m_out.push_back(static_cast<char>(bits >> (8 * i)));
+        }
+    }
+
+    void
+    number()
+    {
+        auto const start = m_pos;
+        bool is_integer = true;
+        if (m_pos < m_in.size() && m_in[m_pos] == '-') {
+            ++m_pos;
+        }
+        auto const digits = m_pos;
+        for (; m_pos < m_in.size(); ++m_pos) {
+            auto c = m_in[m_pos];
+            if (c == '.' || c == 'e' || c == 'E'
+                    || ((c == '+' || c == '-') && !is_integer)) {
+                is_integer = false;
+            } else if (!std::isdigit(static_cast<unsigned char>(c))) {
+                break;
+            }
+        }
+        std::string const text(m_in.begin() + std::ptrdiff_t(start),
+                               m_in.begin() + std::ptrdiff_t(m_pos));
+        if (m_pos == digits || !std::isdigit(
+                    static_cast<unsigned char>(m_in[digits]))) {
+            m_is_valid = false;
+            return;
+        }
+        if (is_integer) {
+            uint64_t value = 0;
+            bool is_overflow = false;
+            for (auto i = digits; i < m_pos && !is_overflow; ++i) {
+                auto digit = static_cast<uint64_t>(m_in[i] - '0');
+                is_overflow = value > (UINT64_MAX - digit) / 10;
+                value = value * 10 + digit;
+            }
+            auto const is_negative = digits != start;
+            if (!is_overflow && (!is_negative || value != 0)) {
+                append(head(is_negative ? 1 : 0,
+                            is_negative ? value - 1 : value));
+                return;
+            }
+        }
+        char* end = nullptr;
+        auto const value = std::strtod(text.c_str(), &end);
+        if (end != text.c_str() + text.size()) {
+            m_is_valid = false;
+            return;
+        }
+        auto const single = static_cast<float>(value);
+        if (static_cast<double>(single) == value) {
+            uint32_t bits = 0;
+            std::memcpy(&bits, &single, sizeof(bits));
+            real(0xfa, bits, 4);
+        } else {
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(bits));
+            real(0xfb, bits, 8);
+        }
+    }
+
+    std::vector<char> const& m_in;
+    std::vector<char>& m_out;
+    std::size_t m_pos;
+    bool m_is_valid;
+};
+
+// filters run in process, selected by name in place of a command
+inline std::map<std::string, Filter>&
+_filters()
+{
+    static std::map<std::string, Filter> res =
+    {
+        { "json", _minify_json },
+        { "css", _minify_css },
+        { "html", _minify_html },
+        { "glsl", _minify_glsl },
+        { "gzip", _gzip },
+        { "cbor", [] (std::vector<char> const& in, std::vector<char>& out)
+            { return JsonToCbor(in, out).convert(); }
+        },
+        // line endings as they are on the checkout of any platform
+        { "lf", [] (std::vector<char> const& in, std::vector<char>& out)
+            {
+                for (std::size_t i = 0; i < in.size(); ++i) {
+                    if (in[i] != '\r' || i + 1 == in.size()
+                            || in[i + 1] != '\n') {
+                        out.push_back(in[i]);
+                    }
+                }
+                return true;
+            }
+        },
+    };
+    return res;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+inline bool
+_make_pipe(int fds[2])
+{
+#if defined(__linux__)
+    return ::pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (::pipe(fds) != 0) {
+        return false;
+    }
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif  // __linux__
+}
+#endif  // __unix__ || __APPLE__
+
+// pipes 'in' through the shell command 'command', false if it can't be
+// started or fails
+inline bool
+_run_filter(std::string const& command,
+            std::vector<char> const& in, std::vector<char>& out)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    // a command that exits before reading everything mustn't end the program
+    static bool const is_ignored = ::signal(SIGPIPE, SIG_IGN) != SIG_ERR;
+    static_cast<void>(is_ignored);
+    int input[2];
+    int output[2];
+    if (!_make_pipe(input)) {
+        return false;
+    }
+    if (!_make_pipe(output)) {
+        ::close(input[0]);
+        ::close(input[1]);
+        return false;
+    }
+    // the pipes are close-on-exec, so commands started by other threads
+    // don't keep them open
+    posix_spawn_file_actions_t actions;
+    ::posix_spawn_file_actions_init(&actions);
+    ::posix_spawn_file_actions_adddup2(&actions, input[0], 0);
+    ::posix_spawn_file_actions_adddup2(&actions, output[1], 1);
+    char const* argv[] = { "sh", "-c", command.c_str(), nullptr };
+    pid_t pid = 0;
+    auto error = ::posix_spawn(&pid, "/bin/sh", &actions, nullptr,
+                               const_cast<char* const*>(argv), environ);
+    ::posix_spawn_file_actions_destroy(&actions);
+    ::close(input[0]);
+    ::close(output[1]);
+    if (error != 0) {
+        ::close(input[1]);
+        ::close(output[0]);
+        return false;
+    }
+    // writes and reads at once, so that neither side waits on a full pipe
+    ::fcntl(input[1], F_SETFL, O_NONBLOCK);
+    int writer = input[1];
+    int reader = output[0];
+    std::size_t written = 0;
+    std::vector<char> buffer(1 << 16);
+    while (reader >= 0) {
+        if (writer >= 0 && written == in.size()) {
+            ::close(writer);
+            writer = -1;
+        }
+        pollfd fds[2] = { { reader, POLLIN, 0 }, { writer, POLLOUT, 0 } };
+        if (::poll(fds, writer >= 0 ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (writer >= 0 && fds[1].revents != 0) {
+            auto count = ::write(writer, in.data() + written,
+                                 std::min(in.size() - written,
+                                          buffer.size()));
+            if (count > 0) {
+                written += static_cast<std::size_t>(count);
+            } else if (errno != EAGAIN && errno != EINTR) {
+                // the command doesn't read the rest
+                written = in.size();
+            }
+        }
+        if (fds[0].revents != 0) {
+            auto count = ::read(reader, buffer.data(), buffer.size());
+            if (count > 0) {
+                out.insert(out.end(), buffer.data(),
+                           buffer.data() + count);
+            } else if (count == 0 || errno != EINTR) {
+                ::close(reader);
+                reader = -1;
+            }
+        }
+    }
+    if (writer >= 0) {
+        ::close(writer);
+    }
+    if (reader >= 0) {
+        ::close(reader);
+    }
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#elif defined(_WIN32)
+    // the input goes through a temporary file, the pipe is one-way here
+    auto const path = _temp_directory() + "\\cpp-generes-filter-"
+            + std::to_string(std::random_device()());
+    std::ofstream(path, std::ios::binary)
+            .write(in.data(), std::streamsize(in.size()));
+    auto pipe = ::_popen((command + " < \"" + path + "\"").c_str(), "rb");
+    if (!pipe) {
+        std::remove(path.c_str());
+        return false;
+    }
+    std::vector<char> buffer(1 << 16);
+    for (std::size_t count;
+         (count = std::fread(buffer.data(), 1, buffer.size(), pipe)) != 0; ) {
+        out.insert(out.end(), buffer.data(), buffer.data() + count);
+    }
+    auto status = ::_pclose(pipe);
+    std::remove(path.c_str());
+    return status == 0;
+#else
+    static_cast<void>(command);
+    static_cast<void>(in);
+    static_cast<void>(out);
+    return false;
+#endif  // __unix__ || __APPLE__
+}
+
+// response files named by 'args' and, in turn, by them; each file is read
+// once, so that files naming each other end
+inline std::vector<std::string>
+_response_files(std::vector<std::string> const& args,
+                std::set<std::string>* visited = nullptr)
+{
+    std::set<std::string> paths;
+    if (!visited) {
+        visited = &paths;
+    }
+    std::vector<std::string> res;
+    for (auto const& arg : args) {
+        if (arg.empty() || arg.front() != '@') {
+            continue;
+        }
+        auto const path = arg.substr(1);
+        if (!visited->insert(_absolute_path(path)).second) {
+            continue;
+        }
+        res.push_back(path);
+        std::ifstream in(path);
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(in, line); ) {
+            lines.push_back(line);
+        }
+        auto nested = _response_files(lines, visited);
+        res.insert(res.end(), nested.begin(), nested.end());
+    }
+    return res;
+}
+
+// file contents and their encodings shared by the bundles of a manifest run,
+// every file is read and encoded in a given mode at most once
+class FileCache
+{
+public:
+    FileCache()
+        : m_mutex(),
+          m_entries(),
+          m_filtered()
+    { }
+
+    // sets the encoding of 'resource' in its mode, through the fragment
+    // store in 'directory' if it is given, returns false if the file can't
+    // be read
+    bool
+    encode(Resource& resource, std::string const& directory)
+    {
+        std::shared_ptr<Entry> entry;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto& ptr = m_entries[std::make_pair(resource.file,
+                                                 resource.member.name)];
+            if (!ptr) {
+                ptr = std::make_shared<Entry>();
+            }
+            entry = ptr;
+        }
+        // other files are read and encoded meanwhile
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        auto it = entry->encoded.find(resource.mode);
+        if (it == entry->encoded.end() && !entry->is_read
+                && _load_encoded(resource, directory)) {
+            entry->encoded[resource.mode] = resource.encoded;
+            return true;
+        }
+        if (!entry->is_read) {
+            entry->data.file = resource.file;
+            entry->data.size = resource.size;
+            entry->data.member = resource.member;
+            entry->is_valid = _read_data(entry->data);
+            entry->is_read = true;
+        }
+        if (!entry->is_valid) {
+            return false;
+        }
+        if (it == entry->encoded.end()) {
+            entry->data.mode = resource.mode;
+            it = entry->encoded.insert(
+                        std::make_pair(resource.mode,
+                                       _encode(entry->data,
+                                               directory))).first;
+        }
+        resource.encoded = it->second;
+        return true;
+    }
+
+    // output of a filter, by the hash of its input and command
+    bool
+    find_filtered(std::string const& key, std::vector<char>& out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_filtered.find(key);
+        if (it == m_filtered.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+
+    void
+    add_filtered(std::string const& key, std::vector<char> const& out)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filtered[key] = out;
+    }
+
+private:
+    struct Entry
+    {
+        Entry()
+            : mutex(),
+              data(),
+              is_read(),
+              is_valid(),
+              encoded()
+        { }
+
+        std::mutex mutex;
+        Resource data;
+        bool is_read;
+        bool is_valid;
+        std::map<std::string, std::string> encoded;
+    };
+
+    std::mutex m_mutex;
+    std::map<std::pair<std::string, std::string>,
+             std::shared_ptr<Entry> > m_entries;
+    std::map<std::string, std::vector<char> > m_filtered;
+};
+
+// selects the built-in minifiers for the extensions that have no filter
+inline void
+_add_minifiers(Options& options)
+{
+    std::pair<char const*, char const*> const minifiers[] =
+    {
+        { "json", "json" }, { "css", "css" }, { "html", "html" },
+        { "htm", "html" }, { "glsl", "glsl" }, { "vert", "glsl" },
+        { "frag", "glsl" }, { "geom", "glsl" }, { "comp", "glsl" },
+        { "tesc", "glsl" }, { "tese", "glsl" },
+    };
+    for (auto const& pair : minifiers) {
+        options.filters.insert(std::make_pair(pair.first, pair.second));
+    }
+}
+
+// command of the filter for the file behind 'resource', the one with the
+// longest matching extension
+inline std::string
+_filter_command(Options const& options, Resource const& resource)
+{
+    auto const& name = resource.member.name.empty() ? resource.file
+                                                    : resource.member.name;
+    std::string res;
+    std::size_t length = 0;
+    for (auto const& pair : options.filters) {
+        if (pair.first.size() > length
+                && _ends_with(name, "." + pair.first)) {
+            res = pair.second;
+            length = pair.first.size();
+        }
+    }
+    return res;
+}
+
+// runs 'in' through a built-in filter or a command; results are kept by
+// the hash of the data and the command in 'cache' for the other bundles,
+// and in --cache-dir along with the cache format
+inline bool
+_run_cached(Options const& options, std::string const& command,
+            std::vector<char> const& in, std::vector<char>& out,
+            FileCache* cache)
+{
+    auto key = Sha256().update(in.data(), in.size())
+            .update(command.c_str(), command.size() + 1).hex();
+    auto const path = options.cache_dir.empty()
+            ? std::string() : options.cache_dir + "/" + key + "-filter-"
+              + cache_format;
+    auto is_done = (cache && cache->find_filtered(key, out))
+            || (!path.empty() && _load_cached(path, out));
+    if (!is_done) {
+        auto it = _filters().find(command);
+        is_done = it != _filters().end() ? it->second(in, out)
+                                         : _run_filter(command, in, out);
+        if (!is_done) {
+            return false;
+        }
+        if (!path.empty()) {
+            _store_cached(path, out.data(), out.size());
+        }
+    }
+    if (cache) {
+        cache->add_filtered(key, out);
+    }
+    return true;
+}
+
+// runs the data of the resources through the filters given for their
+// extensions, in parallel
+inline bool
+_apply_filters(Options const& options,
+               std::vector<Resource>& resources, FileCache* cache = nullptr)
+{
+    std::vector<Resource*> filtered;
+    std::vector<std::string> commands;
+    for (auto& resource : resources) {
+        auto command = _filter_command(options, resource);
+        if (!command.empty() && resource.filter.empty()) {
+            filtered.push_back(&resource);
+            commands.push_back(command);
+        }
+    }
+    if (filtered.empty()) {
+        return true;
+    }
+    _read_files(filtered);
+    std::atomic<bool> res(true);
+    _parallel_for(filtered.size(), _hardware_threads(), [&] (std::size_t i)
+    {
+        auto& resource = *filtered[i];
+        auto const& command = commands[i];
+        if (resource.data.size() != resource.size) {
+            // reported while reading
+            res = false;
+            return;
+        }
+        std::vector<char> out;
+        if (!_run_cached(options, command, resource.data, out, cache)) {
+            std::cout << "[FAIL] Filter '" << command << "' failed on '"
+                      << resource.alias << "'" << std::endl;
+            res = false;
+            return;
+        }
+        resource.data = std::move(out);
+        resource.size = resource.data.size();
+        resource.filter = command;
+        resource.encoded.clear();
+    });
+    return res;
+}
+
+// parses a number of a text table as an element of 'type' into 'bits',
+// fails on anything else and on values out of its range
+inline bool
+_parse_element(std::string const& token, std::string const& type,
+               uint64_t& bits)
+{
+    auto const size = _element_size(type);
+    char* end = nullptr;
+    errno = 0;
+    if (type[0] == 'f') {
+        auto value = std::strtod(token.c_str(), &end);
+        if (errno == ERANGE && std::isinf(value)) {
+            return false;
+        }
+        if (size == 4) {
+            if (std::isfinite(value) && std::fabs(value) > FLT_MAX) {
+                return false;
+            }
+            auto const single = static_cast<float>(value);
+            uint32_t single_bits = 0;
+            std::memcpy(&single_bits, &single, sizeof(single_bits));
+            bits = single_bits;
+        } else {
+            std::memcpy(&bits, &value, sizeof(bits));
+        }
+    } else if (type[0] == 'i') {
+        auto value = std::strtoll(token.c_str(), &end, 10);
+        auto const max = int64_t(~uint64_t(0) >> (65 - 8 * size));
+        if (errno == ERANGE || value > max || value < -max - 1) {
+            return false;
+        }
+        bits = uint64_t(value);
+    } else {
+        auto value = std::strtoull(token.c_str(), &end, 10);
+        if (token[0] == '-' || errno == ERANGE
+                || (size < 8 && (value >> (8 * size)) != 0)) {
+            return false;
+        }
+        bits = value;
+    }
+    return end == token.c_str() + token.size();
+}
+
+// code points of UTF-8 text after an optional byte order mark; fails with
+// the offset of the first invalid sequence, overlong forms, surrogates and
+// values past U+10FFFF included
+inline bool
+_decode_utf8(std::vector<char> const& data, std::vector<uint32_t>& codes,
+             std::size_t& offset)
+{
+    uint32_t const min_codes[] = { 0, 0x80, 0x800, 0x10000 };
+    std::size_t i = data.size() >= 3 && data[0] == '\xef' && data[1] == '\xbb'
+            && data[2] == '\xbf' ? 3 : 0;
+    codes.reserve(data.size() - i);
+    while (i < data.size()) {
+        offset = i;
+        auto const c = static_cast<unsigned char>(data[i]);
+        std::size_t const count = c < 0x80 ? 0 : c >= 0xc2 && c < 0xe0 ? 1
+                                  : c >= 0xe0 && c < 0xf0 ? 2
+                                  : c >= 0xf0 && c < 0xf5 ? 3 : 4;
+        if (count == 4 || data.size() - i <= count) {
+            return false;
+        }
+        uint32_t code = count == 0 ? c : c & (0x3fu >> count);
+        for (std::size_t j = 1; j <= count; ++j) {
+            auto const next = static_cast<unsigned char>(data[i + j]);
+            if ((next & 0xc0) != 0x80) {
+                return false;
+            }
+            code = code << 6 | (next & 0x3fu);
+        }
+        if (code < min_codes[count] || (code >= 0xd800 && code < 0xe000)
+                || code > 0x10ffff) {
+            return false;
+        }
+        codes.push_back(code);
+        i += count + 1;
+    }
+    return true;
+}
+
+// little-endian UTF-16 or UTF-32 code units of the UTF-8 text of 'resource'
+inline bool
+_transcode_utf8(Resource const& resource, std::vector<char>& out)
+{
+    std::vector<uint32_t> codes;
+    std::size_t offset = 0;
+    if (!_decode_utf8(resource.data, codes, offset)) {
+        std::cout << "[FAIL] Resource '" << resource.alias << "' isn't valid "
+                  << "UTF-8 at byte " << offset << std::endl;
+        return false;
+    }
+    auto const put = [&out] (uint32_t unit, std::size_t size)
+    {
+        for (std::size_t i = 0; i < size; ++i) {
+            out.push_back(static_cast<char>(unit >> (8 * i)));
+        }
+    };
+    out.clear();
+    for (auto code : codes) {
+        if (resource.type == "utf32") {
+            put(code, 4);
+        } else if (code < 0x10000) {
+            put(code, 2);
+        } else {
+            put(0xd800 + ((code - 0x10000) >> 10), 2);
+            put(0xdc00 + ((code - 0x10000) & 0x3ff), 2);
+        }
+    }
+    return true;
+}
+
+// little-endian elements of the type of 'resource': numbers separated by
+// whitespace, ',' or ';' are read from text tables (.csv, .tsv and .txt,
+// where '#' starts a comment), binary data is taken as elements in the
+// byte order of the type
+inline bool
+_to_elements(Resource const& resource, std::vector<char>& out)
+{
+    auto const& type = resource.type;
+    auto const size = _element_size(type);
+    auto const& data = resource.data;
+    if (_is_utf(type)) {
+        return _transcode_utf8(resource, out);
+    }
+    auto const& name = resource.member.name.empty() ? resource.file
+                                                    : resource.member.name;
+    if (!_ends_with(name, ".csv") && !_ends_with(name, ".tsv")
+            && !_ends_with(name, ".txt")) {
+        if (data.size() % size != 0) {
+            std::cout << "[FAIL] Resource '" << resource.alias << "' of "
+                      << data.size() << " bytes can't hold " << type
+                      << " elements" << std::endl;
+            return false;
+        }
+        out = data;
+        if (_ends_with(type, "be")) {
+            for (std::size_t i = 0; i < out.size(); i += size) {
+                std::reverse(out.begin() + std::ptrdiff_t(i),
+                             out.begin() + std::ptrdiff_t(i + size));
+            }
+        }
+        return true;
+    }
+    auto const is_separator = [] (char c)
+    {
+        return _is_space(c) || c == ',' || c == ';' || c == '#';
+    };
+    out.clear();
+    std::size_t line = 1;
+    for (std::size_t i = 0; i < data.size(); ) {
+        if (data[i] == '#') {
+            while (i < data.size() && data[i] != '\n') {
+                ++i;
+            }
+            continue;
+        }
+        if (is_separator(data[i])) {
+            line += data[i] == '\n';
+            ++i;
+            continue;
+        }
+        auto end = i;
+        while (end < data.size() && !is_separator(data[end])) {
+            ++end;
+        }
+        std::string const token(data.begin() + std::ptrdiff_t(i),
+                                data.begin() + std::ptrdiff_t(end));
+        uint64_t bits = 0;
+        if (!_parse_element(token, type, bits)) {
+            std::cout << "[FAIL] Resource '" << resource.alias << "' has "
+                      << "no " << type << " value '" << token << "' on line "
+                      << line << std::endl;
+            return false;
+        }
+        for (std::size_t j = 0; j < size; ++j) {
+            out.push_back(static_cast<char>(bits >> (8 * j)));
+        }
+        i = end;
+    }
+    return true;
+}
+
+// replaces the data of typed resources by their elements, once
+inline bool
+_convert_elements(std::vector<Resource>& resources)
+{
+    std::vector<Resource*> typed;
+    for (auto& resource : resources) {
+        if (!resource.type.empty() && !resource.is_converted) {
+            typed.push_back(&resource);
+        }
+    }
+    if (typed.empty()) {
+        return true;
+    }
+    _read_files(typed);
+    bool res = true;
+    for (auto resource : typed) {
+        std::vector<char> out;
+        // unread data is reported while reading
+        if (resource->data.size() != resource->size
+                || !_to_elements(*resource, out)) {
+            res = false;
+            continue;
+        }
+        resource->data = std::move(out);
+        resource->size = resource->data.size();
+        resource->is_converted = true;
+        resource->encoded.clear();
+    }
+    return res;
+}
+
+// command of the brotli encoder if it is installed, checked once
+inline std::string const&
+_brotli_command()
+{
+#if defined(_WIN32)
+    static char const* const probe = "brotli --version >nul 2>&1";
+#else
+    static char const* const probe = "brotli --version >/dev/null 2>&1";
+#endif  // _WIN32
+    static std::string const res = [] ()
+    {
+        std::vector<char> out;
+        return _run_filter(probe, std::vector<char>(), out)
+                ? std::string("brotli -c -q 11") : std::string();
+    }();
+    return res;
+}
+
+// sets the ETags and the subresource integrity hashes of the resources and
+// adds their encodings in the codings of --precompress, where smaller, as
+// '<alias>.gz' and '<alias>.br' for web servers; typed data is left as it is
+inline bool
+_add_variants(Options const& options,
+              std::vector<Resource>& resources, FileCache* cache = nullptr)
+{
+    if (options.precompress.empty()) {
+        return true;
+    }
+    struct Encoding
+    {
+        char const* name;
+        char const* suffix;
+        std::string command;
+    };
+    std::vector<Encoding> encodings;
+    for (auto const& coding : options.precompress) {
+        if (coding == "gzip") {
+            encodings.push_back(Encoding{ "gzip", "gz", "gzip" });
+            continue;
+        }
+        // skipping an encoder that isn't installed would make the output
+        // depend on the host it is generated on
+        if (_brotli_command().empty()) {
+            std::cout << "[FAIL] The brotli command for --precompress br is "
+                      << "not installed" << std::endl;
+            return false;
+        }
+        encodings.push_back(Encoding{ "br", "br", _brotli_command() });
+    }
+    std::set<std::string> aliases;
+    std::vector<Resource*> hashed;
+    for (auto& resource : resources) {
+        aliases.insert(resource.alias);
+        if (resource.type.empty() && resource.encoding.empty()) {
+            hashed.push_back(&resource);
+        }
+    }
+    _read_files(hashed);
+    std::vector<std::vector<Resource> > variants(hashed.size());
+    std::atomic<bool> res(true);
+    _parallel_for(hashed.size(), _hardware_threads(), [&] (std::size_t i)
+    {
+        auto& resource = *hashed[i];
+        if (resource.data.size() != resource.size) {
+            // reported while reading
+            res = false;
+            return;
+        }
+        auto const& data = resource.data;
+        auto const tag = Sha256().update(data.data(), data.size()).hex()
+                .substr(0, 32);
+        resource.etag = "\"" + tag + "\"";
+        resource.integrity = "sha384-"
+                + _base64(Sha384().update(data.data(), data.size()).digest());
+        for (auto const& encoding : encodings) {
+            auto const alias = resource.alias + "." + encoding.suffix;
+            std::vector<char> out;
+            if (aliases.count(alias) != 0) {
+                continue;
+            }
+            if (!_run_cached(options, encoding.command, data, out, cache)) {
+                std::cout << "[FAIL] Encoder '" << encoding.command
+                          << "' failed on '" << resource.alias << "'"
+                          << std::endl;
+                res = false;
+                return;
+            }
+            if (out.size() >= data.size()) {
+                continue;
+            }
+            Resource variant;
+            variant.file = resource.file;
+            variant.member = resource.member;
+            variant.alias = alias;
+            variant.preferred = resource.preferred;
+            variant.size = out.size();
+            variant.data = std::move(out);
+            variant.filter = encoding.command;
+            variant.encoding = encoding.name;
+            variant.etag = "\"" + tag + "-" + encoding.suffix + "\"";
+            variant.integrity = resource.integrity;
+            variants[i].push_back(std::move(variant));
+        }
+    });
+    for (auto& list : variants) {
+        for (auto& variant : list) {
+            resources.push_back(std::move(variant));
+        }
+    }
+    return res;
+}
+
+// names the resources with aliases matching --fingerprint after a hash of
+// their contents, put before the extension: 'js/app.js' is also known as
+// 'js/app.3f2a9c1d.js'
+inline bool
+_add_fingerprints(Options const& options, std::vector<Resource>& resources)
+{
+    std::vector<Resource*> selected;
+    for (auto& resource : resources) {
+        auto const& alias = resource.alias;
+        auto is_selected = resource.encoding.empty() && std::any_of(
+                    options.fingerprints.begin(), options.fingerprints.end(),
+                    [&alias] (std::string const& pattern)
+        { return _glob_match(pattern.c_str(), alias.c_str()); });
+        if (is_selected) {
+            selected.push_back(&resource);
+        }
+    }
+    _read_files(selected);
+    bool res = true;
+    for (auto resource : selected) {
+        if (resource->data.size() != resource->size) {
+            // reported while reading
+            res = false;
+            continue;
+        }
+        auto const& alias = resource->alias;
+        auto const hash = Sha256().update(resource->data.data(),
+                                          resource->data.size()).hex();
+        auto const slash = alias.find_last_of('/');
+        auto const base = slash == std::string::npos ? 0 : slash + 1;
+        auto dot = alias.find_last_of('.');
+        if (dot == std::string::npos || dot <= base) {
+            dot = alias.size();
+        }
+        resource->fingerprinted = alias.substr(0, dot) + "."
+                + hash.substr(0, 8) + alias.substr(dot);
+    }
+    return res;
+}
+
+#if defined(__linux__)
+class Watcher
+{
+public:
+    Watcher()
+        : m_fd(::inotify_init1(IN_CLOEXEC)),
+          m_dirs(),
+          m_files(),
+          m_listed()
+    { }
+
+    Watcher(Watcher const&) = delete;
+    Watcher& operator =(Watcher const&) = delete;
+
+    ~Watcher()
+    {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    bool
+    is_valid() const
+    {
+        return m_fd >= 0;
+    }
+
+    void
+    add(std::string const& file)
+    {
+        auto path = _absolute_path(file);
+        auto dir = _directory_name(path);
+        // a file that doesn't exist yet isn't resolved, but its directory
+        // is, lest it is watched under another name
+        if (dir.empty() || dir[0] != '/') {
+            dir = _absolute_path(dir.empty() ? "." : dir);
+            path = dir + "/" + _file_name(path);
+        }
+        // watch directories: editors usually save by renaming a new file
+        int wd = ::inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE
+                                     | IN_MOVED_TO | IN_MASK_ADD);
+        if (wd >= 0) {
+            m_dirs[wd] = dir;
+        }
+        m_files.insert(path);
+    }
+
+    // watches the files that come and go in the directory 'path': changes
+    // of its entries report 'path' itself, and written files their paths
+    void
+    add_directory(std::string const& path)
+    {
+        auto const dir = _absolute_path(path);
+        int wd = ::inotify_add_watch(m_fd, dir.c_str(), IN_CREATE | IN_DELETE
+                                     | IN_MOVED_FROM | IN_MOVED_TO
+                                     | IN_CLOSE_WRITE | IN_MASK_ADD);
+        if (wd >= 0) {
+            m_dirs[wd] = dir;
+            m_listed.insert(dir);
+        }
+    }
+
+    // blocks until watched files change, then collects further changes
+    // until none arrive for 'debounce' milliseconds
+    std::set<std::string>
+    wait(int debounce)
+    {
+        std::set<std::string> res;
+        int timeout = -1;
+        for (;;) {
+            pollfd fds = { m_fd, POLLIN, 0 };
+            int ready = ::poll(&fds, 1, timeout);
+            if (ready <= 0) {
+                if (ready == 0 && !res.empty()) {
+                    return res;
+                }
+                continue;
+            }
+            alignas(inotify_event) char buffer[4096];
+            auto len = ::read(m_fd, buffer, sizeof(buffer));
+            for (auto ptr = buffer; len > 0 && ptr < buffer + len; ) {
+                auto event = reinterpret_cast<inotify_event const*>(ptr);
+                ptr += sizeof(inotify_event) + event->len;
+                auto dir = m_dirs.find(event->wd);
+                if (event->len == 0 || dir == m_dirs.end()) {
+                    continue;
+                }
+                auto path = dir->second + "/" + event->name;
+                auto const is_listed = m_listed.count(dir->second) != 0;
+                if (is_listed && (event->mask & (IN_CREATE | IN_DELETE
+                                                 | IN_MOVED_FROM
+                                                 | IN_MOVED_TO)) != 0) {
+                    res.insert(dir->second);
+                }
+                if (m_files.count(path) != 0 || (is_listed && (event->mask
+                        & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0)) {
+                    res.insert(path);
+                }
+            }
+            if (!res.empty()) {
+                timeout = debounce;
+            }
+        }
+    }
+
+private:
+    int m_fd;
+    std::map<int, std::string> m_dirs;
+    std::set<std::string> m_files;
+    std::set<std::string> m_listed;
+};
+#endif  // __linux__
+
+inline void
+_write_dev_includes(std::ostream& file)
+{
+    file << "#if defined(CPP_GENERES_DEVELOPMENT)\n";
+    file << "#include <fstream>\n";
+    file << "#include <iterator>\n";
+    file << "#include <mutex>\n";
+    file << "#include <utility>\n";
+    file << "#include <vector>\n";
+    file << "#if defined(__linux__)\n";
+    file << "#include <sys/inotify.h>\n";
+    file << "#include <unistd.h>\n";
+    file << "#include <thread>\n";
+    file << "#endif\n";
+    file << "#endif  // CPP_GENERES_DEVELOPMENT\n";
+}
+
+inline void
+_write_dev_runtime(std::ostream& file)
+{
+    file << "#if defined(CPP_GENERES_DEVELOPMENT) "
+            "&& !defined(CPP_GENERES_DEV_RUNTIME_)\n";
+    file << "#define CPP_GENERES_DEV_RUNTIME_\n";
+    file << "namespace cpp_generes {\n";
+    file << "namespace dev {\n";
+    file << "// Serves resources from the files they were generated from.\n";
+    file << "// Files are read on first use and read again whenever a write to"
+            " them is\n";
+    file << "// closed or a new version is moved in. Every version is a copy"
+            " that is\n";
+    file << "// never freed, so pointers handed out earlier stay valid and keep"
+            " their\n";
+    file << "// contents for the lifetime of the process, even if the file is"
+            " rewritten\n";
+    file << "// in place.\n";
+    file << "class registry\n";
+    file << "{\n";
+    file << "public:\n";
+    file << "    typedef std::pair<uint8_t const*, std::size_t> blob;\n";
+    file << "\n";
+    file << "    static registry& instance()\n";
+    file << "    {\n";
+    file << "        // never destroyed: the watching thread outlives static"
+            " destruction\n";
+    file << "        static registry* res = new registry();\n";
+    file << "        return *res;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    blob load(std::string const& path)\n";
+    file << "    {\n";
+    file << "        std::lock_guard<std::mutex> lock(m_mutex);\n";
+    file << "        auto it = m_blobs.find(path);\n";
+    file << "        if (it == m_blobs.end()) {\n";
+    file << "            it = m_blobs.emplace(path, read_file(path)).first;\n";
+    file << "            watch(path);\n";
+    file << "        }\n";
+    file << "        return it->second;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "private:\n";
+    file << "    registry()\n";
+    file << "        : m_mutex(), m_blobs(), m_dirs(), m_fd(-1)\n";
+    file << "    { }\n";
+    file << "\n";
+    file << "    static blob read_file(std::string const& path)\n";
+    file << "    {\n";
+    file << "        static uint8_t const empty = 0;\n";
+    file << "        std::ifstream in(path.c_str(), std::ios::binary);\n";
+    file << "        if (!in.is_open()) {\n";
+    file << "            return blob(nullptr, 0);\n";
+    file << "        }\n";
+    file << "        auto buffer = new std::vector<uint8_t>(\n";
+    file << "                    (std::istreambuf_iterator<char>(in)),"
+            " std::istreambuf_iterator<char>());\n";
+    file << "        if (in.bad()) {\n";
+    file << "            delete buffer;\n";
+    file << "            return blob(nullptr, 0);\n";
+    file << "        }\n";
+    file << "        return buffer->empty() ? blob(&empty, 0)\n";
+    file << "                               : blob(buffer->data(),"
+            " buffer->size());\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    void watch(std::string const& path)\n";
+    file << "    {\n";
+    file << "#if defined(__linux__)\n";
+    file << "        // watch the directory: editors usually save by renaming"
+            " a new file;\n";
+    file << "        // its events are matched by the path up to the name, as"
+            " it was loaded\n";
+    file << "        auto pos = path.find_last_of('/');\n";
+    file << "        auto prefix = pos == std::string::npos ? std::string()\n";
+    file << "                                               : path.substr(0,"
+            " pos + 1);\n";
+    file << "        auto dir = prefix.empty() ? std::string(\".\") :"
+            " prefix;\n";
+    file << "        if (m_fd < 0) {\n";
+    file << "            m_fd = ::inotify_init1(IN_CLOEXEC);\n";
+    file << "            if (m_fd < 0) {\n";
+    file << "                return;\n";
+    file << "            }\n";
+    file << "            std::thread(&registry::listen, this).detach();\n";
+    file << "        }\n";
+    file << "        int wd = ::inotify_add_watch(m_fd, dir.c_str(),"
+            " IN_CLOSE_WRITE | IN_MOVED_TO);\n";
+    file << "        if (wd >= 0) {\n";
+    file << "            m_dirs[wd] = prefix;\n";
+    file << "        }\n";
+    file << "#else\n";
+    file << "        (void)path;\n";
+    file << "#endif\n";
+    file << "    }\n";
+    file << "\n";
+    file << "#if defined(__linux__)\n";
+    file << "    void listen()\n";
+    file << "    {\n";
+    file << "        alignas(inotify_event) char buffer[4096];\n";
+    file << "        for (;;) {\n";
+    file << "            auto len = ::read(m_fd, buffer, sizeof(buffer));\n";
+    file << "            if (len <= 0) {\n";
+    file << "                return;\n";
+    file << "            }\n";
+    file << "            for (char* ptr = buffer; ptr < buffer + len; ) {\n";
+    file << "                auto event"
+            " = reinterpret_cast<inotify_event*>(ptr);\n";
+    file << "                ptr += sizeof(inotify_event) + event->len;\n";
+    file << "                if (event->len == 0) {\n";
+    file << "                    continue;\n";
+    file << "                }\n";
+    file << "                std::lock_guard<std::mutex> lock(m_mutex);\n";
+    file << "                auto dir = m_dirs.find(event->wd);\n";
+    file << "                if (dir == m_dirs.end()) {\n";
+    file << "                    continue;\n";
+    file << "                }\n";
+    file << "                auto it = m_blobs.find(dir->second +"
+            " event->name);\n";
+    file << "                if (it != m_blobs.end()) {\n";
+    file << "                    auto res = read_file(it->first);\n";
+    file << "                    if (res.first) {\n";
+    file << "                        it->second = res;\n";
+    file << "                    }\n";
+    file << "                }\n";
+    file << "            }\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "#endif\n";
+    file << "\n";
+    file << "    std::mutex m_mutex;\n";
+    file << "    std::unordered_map<std::string, blob> m_blobs;\n";
+    file << "    std::unordered_map<int, std::string> m_dirs;\n";
+    file << "    int m_fd;\n";
+    file << "};\n";
+    file << "}  // namespace dev\n";
+    file << "}  // namespace cpp_generes\n";
+    file << "#endif  // CPP_GENERES_DEVELOPMENT\n";
+}
+
+// system headers of the zero-copy accessors, only iovec for declarations
+inline void
+_write_io_includes(std::ostream& file, bool is_declaration = false)
+{
+    file << "#if defined(__unix__) || defined(__APPLE__)\n";
+    file << "#include <sys/uio.h>\n";
+    if (!is_declaration) {
+        file << "#include <fcntl.h>\n";
+        file << "#include <sys/stat.h>\n";
+        file << "#include <unistd.h>\n";
+        file << "#include <mutex>\n";
+        file << "#endif\n";
+        file << "#if defined(__linux__)\n";
+        file << "#include <link.h>\n";
+    }
+    file << "#endif\n";
+}
+
+inline void
+_write_io_runtime(std::ostream& file)
+{
+    file << "#if (defined(__unix__) || defined(__APPLE__)) "
+            "&& !defined(CPP_GENERES_IO_RUNTIME_)\n";
+    file << "#define CPP_GENERES_IO_RUNTIME_\n";
+    file << "namespace cpp_generes {\n";
+    file << "namespace io {\n";
+    file << "// Descriptors of the files resources are stored in, for"
+            " sendfile or splice.\n";
+    file << "// Files are opened on first use and again whenever they are"
+            " replaced on\n";
+    file << "// disk. Descriptors are never closed, so those handed out"
+            " earlier stay\n";
+    file << "// valid for the lifetime of the process.\n";
+    file << "class files\n";
+    file << "{\n";
+    file << "public:\n";
+    file << "    typedef std::pair<int, unsigned long long> location;\n";
+    file << "\n";
+    file << "    static files& instance()\n";
+    file << "    {\n";
+    file << "        static files res;\n";
+    file << "        return res;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    int open(std::string const& path)\n";
+    file << "    {\n";
+    file << "        std::lock_guard<std::mutex> lock(m_mutex);\n";
+    file << "        return open_locked(path);\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // file and offset the loaded bytes [data, data + size) were"
+            " read from,\n";
+    file << "    // { -1, 0 } if they aren't stored as they are in one"
+            " segment of a file\n";
+    file << "    location image(void const* data, std::size_t size)\n";
+    file << "    {\n";
+    file << "#if defined(__linux__)\n";
+    file << "        auto const addr = reinterpret_cast<uintptr_t>(data);\n";
+    file << "        std::lock_guard<std::mutex> lock(m_mutex);\n";
+    file << "        // libraries loaded since the last scan are found on the"
+            " next one\n";
+    file << "        for (int pass = 0; data && pass < 2; ++pass) {\n";
+    file << "            for (auto const& it : m_segments) {\n";
+    file << "                if (addr >= it.begin && addr - it.begin <="
+            " it.size\n";
+    file << "                        && size <= it.size - (addr - it.begin))"
+            " {\n";
+    file << "                    int fd = open_locked(it.path);\n";
+    file << "                    return fd < 0 ? location(-1, 0)\n";
+    file << "                                  : location(fd, it.offset"
+            " + (addr - it.begin));\n";
+    file << "                }\n";
+    file << "            }\n";
+    file << "            if (pass == 0) {\n";
+    file << "                m_segments.clear();\n";
+    file << "                ::dl_iterate_phdr(&files::add_segments,"
+            " &m_segments);\n";
+    file << "            }\n";
+    file << "        }\n";
+    file << "#else\n";
+    file << "        (void)data;\n";
+    file << "        (void)size;\n";
+    file << "#endif\n";
+    file << "        return location(-1, 0);\n";
+    file << "    }\n";
+    file << "\n";
+    file << "private:\n";
+    file << "    struct entry\n";
+    file << "    {\n";
+    file << "        int fd;\n";
+    file << "        dev_t device;\n";
+    file << "        ino_t inode;\n";
+    file << "    };\n";
+    file << "\n";
+    file << "    struct segment\n";
+    file << "    {\n";
+    file << "        uintptr_t begin;\n";
+    file << "        uintptr_t size;\n";
+    file << "        unsigned long long offset;\n";
+    file << "        std::string path;\n";
+    file << "    };\n";
+    file << "\n";
+    file << "    files()\n";
+    file << "        : m_mutex(), m_files(), m_segments()\n";
+    file << "    { }\n";
+    file << "\n";
+    file << "    int open_locked(std::string const& path)\n";
+    file << "    {\n";
+    file << "        struct stat info;\n";
+    file << "        auto it = m_files.find(path);\n";
+    file << "        if (it != m_files.end() && (::stat(path.c_str(), &info)"
+            " != 0\n";
+    file << "                || (info.st_dev == it->second.device\n";
+    file << "                    && info.st_ino == it->second.inode))) {\n";
+    file << "            return it->second.fd;\n";
+    file << "        }\n";
+    file << "        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);\n";
+    file << "        if (fd < 0 || ::fstat(fd, &info) != 0) {\n";
+    file << "            if (fd >= 0) {\n";
+    file << "                ::close(fd);\n";
+    file << "            }\n";
+    file << "            return it != m_files.end() ? it->second.fd : -1;\n";
+    file << "        }\n";
+    file << "        m_files[path] = entry{ fd, info.st_dev, info.st_ino"
+            " };\n";
+    file << "        return fd;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "#if defined(__linux__)\n";
+    file << "    static int add_segments(dl_phdr_info* info, std::size_t,"
+            " void* data)\n";
+    file << "    {\n";
+    file << "        auto segments = static_cast<std::vector<segment>*>"
+            "(data);\n";
+    file << "        // the program itself has no name\n";
+    file << "        std::string path = info->dlpi_name && *info->dlpi_name\n";
+    file << "                ? info->dlpi_name : \"/proc/self/exe\";\n";
+    file << "        for (std::size_t i = 0; i < info->dlpi_phnum; ++i) {\n";
+    file << "            auto const& header = info->dlpi_phdr[i];\n";
+    file << "            if (header.p_type == PT_LOAD) {\n";
+    file << "                segments->push_back(segment{\n";
+    file << "                    info->dlpi_addr + header.p_vaddr,"
+            " header.p_filesz,\n";
+    file << "                    header.p_offset, path });\n";
+    file << "            }\n";
+    file << "        }\n";
+    file << "        return 0;\n";
+    file << "    }\n";
+    file << "#endif\n";
+    file << "\n";
+    file << "    std::mutex m_mutex;\n";
+    file << "    std::unordered_map<std::string, entry> m_files;\n";
+    file << "    std::vector<segment> m_segments;\n";
+    file << "};\n";
+    file << "}  // namespace io\n";
+    file << "}  // namespace cpp_generes\n";
+    file << "#endif  // __unix__ || __APPLE__\n";
+}
+
+inline void
+_write_cbor_includes(std::ostream& file)
+{
+    file << "#include <cmath>\n";
+    file << "#include <cstddef>\n";
+    file << "#include <cstdint>\n";
+    file << "#include <cstring>\n";
+    file << "#include <string>\n";
+}
+
+inline std::string
+_source_path(std::string const& output, std::string const& extension)
+{
+    auto const name = _file_name(output);
+    auto pos = name.find_last_of('.');
+    if (pos == std::string::npos) {
+        return output + extension;
+    }
+    return output.substr(0, output.size() - (name.size() - pos)) + extension;
+}
+
+// read-only view of the CBOR written by the 'cbor' filter, shared by all
+// generated headers; module interfaces and the split layout take it from a
+// header of its own, so that it is one entity for all modules and the API
+// header stays light
+inline void
+_write_cbor_view(std::ostream& file)
+{
+    file << "#if !defined(CPP_GENERES_CBOR_)\n";
+    file << "#define CPP_GENERES_CBOR_\n";
+    _write_cbor_includes(file);
+    file << "\n";
+    file << "namespace cpp_generes {\n";
+    file << "// Read-only view of a CBOR data item (RFC 8949) with definite"
+            " lengths, as\n";
+    file << "// written by the 'cbor' filter. Lookups walk the encoded data in"
+            " place,\n";
+    file << "// missing or malformed items give an invalid view.\n";
+    file << "class cbor\n";
+    file << "{\n";
+    file << "public:\n";
+    file << "    enum kind { invalid, integer, bytes, text, array, map,"
+            " boolean, null,\n";
+    file << "                real, other };\n";
+    file << "\n";
+    file << "    cbor()\n";
+    file << "        : m_data(nullptr), m_end(nullptr)\n";
+    file << "    { }\n";
+    file << "\n";
+    file << "    cbor(void const* data, std::size_t size)\n";
+    file << "        : m_data(static_cast<unsigned char const*>(data)),\n";
+    file << "          m_end(static_cast<unsigned char const*>(data) + size)\n";
+    file << "    { }\n";
+    file << "\n";
+    file << "    kind type() const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (!head(m_data, major, arg, next)) {\n";
+    file << "            return invalid;\n";
+    file << "        }\n";
+    file << "        switch (major) {\n";
+    file << "            case 0 :\n";
+    file << "            case 1 :\n";
+    file << "                return integer;\n";
+    file << "            case 2 :\n";
+    file << "                return bytes;\n";
+    file << "            case 3 :\n";
+    file << "                return text;\n";
+    file << "            case 4 :\n";
+    file << "                return array;\n";
+    file << "            case 5 :\n";
+    file << "                return map;\n";
+    file << "            case 6 :\n";
+    file << "                return cbor(next, std::size_t(m_end -"
+            " next)).type();\n";
+    file << "            default :\n";
+    file << "                break;\n";
+    file << "        }\n";
+    file << "        switch (*m_data & 31) {\n";
+    file << "            case 20 :\n";
+    file << "            case 21 :\n";
+    file << "                return boolean;\n";
+    file << "            case 22 :\n";
+    file << "                return null;\n";
+    file << "            case 25 :\n";
+    file << "            case 26 :\n";
+    file << "            case 27 :\n";
+    file << "                return real;\n";
+    file << "            default :\n";
+    file << "                return other;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    explicit operator bool() const\n";
+    file << "    {\n";
+    file << "        return type() != invalid;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // elements of an array or a map, bytes of a string\n";
+    file << "    std::size_t size() const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (!head(m_data, major, arg, next) || major < 2 || major"
+            " > 5) {\n";
+    file << "            return 0;\n";
+    file << "        }\n";
+    file << "        return std::size_t(arg);\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    cbor operator[](std::size_t index) const\n";
+    file << "    {\n";
+    file << "        auto item = content(4);\n";
+    file << "        for (std::size_t i = 0; item.m_data && i < index; ++i)"
+            " {\n";
+    file << "            item = item.next();\n";
+    file << "        }\n";
+    file << "        return index < size() ? item : cbor();\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    cbor operator[](std::string const& key) const\n";
+    file << "    {\n";
+    file << "        return find(key.data(), key.size());\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // value of the first entry of a map with this text key\n";
+    file << "    cbor find(char const* key, std::size_t length) const\n";
+    file << "    {\n";
+    file << "        auto item = content(5);\n";
+    file << "        for (std::size_t i = 0, n = size(); item.m_data && i < n;"
+            " ++i) {\n";
+    file << "            auto value = item.next();\n";
+    file << "            auto str = item.data();\n";
+    file << "            if (str && item.type() == text && item.size() =="
+            " length\n";
+    file << "                    && std::memcmp(str, key, length) == 0) {\n";
+    file << "                return value;\n";
+    file << "            }\n";
+    file << "            item = value.next();\n";
+    file << "        }\n";
+    file << "        return cbor();\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    cbor key(std::size_t index) const\n";
+    file << "    {\n";
+    file << "        auto item = content(5);\n";
+    file << "        for (std::size_t i = 0; item.m_data && i < index; ++i)"
+            " {\n";
+    file << "            item = item.next().next();\n";
+    file << "        }\n";
+    file << "        return index < size() ? item : cbor();\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    cbor value(std::size_t index) const\n";
+    file << "    {\n";
+    file << "        return key(index).next();\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // bytes of a string, not terminated\n";
+    file << "    char const* data() const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (!head(m_data, major, arg, next) || (major != 2 &&"
+            " major != 3)\n";
+    file << "                || uint64_t(m_end - next) < arg) {\n";
+    file << "            return nullptr;\n";
+    file << "        }\n";
+    file << "        return reinterpret_cast<char const*>(next);\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    std::string as_string() const\n";
+    file << "    {\n";
+    file << "        auto str = data();\n";
+    file << "        return str ? std::string(str, size()) : std::string();\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    int64_t as_int(int64_t fallback = 0) const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (!head(m_data, major, arg, next) || major > 1) {\n";
+    file << "            return type() == real ? int64_t(as_double()) :"
+            " fallback;\n";
+    file << "        }\n";
+    file << "        return major == 0 ? int64_t(arg) : -1 - int64_t(arg);\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    double as_double(double fallback = 0) const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (!head(m_data, major, arg, next)) {\n";
+    file << "            return fallback;\n";
+    file << "        }\n";
+    file << "        if (major < 2) {\n";
+    file << "            return major == 0 ? double(arg) : -1 - double(arg);\n";
+    file << "        }\n";
+    file << "        if (major != 7) {\n";
+    file << "            return fallback;\n";
+    file << "        }\n";
+    file << "        switch (*m_data & 31) {\n";
+    file << "            case 25 : {\n";
+    file << "                auto exp = int(arg >> 10 & 31);\n";
+    file << "                auto res = exp == 0 ? std::ldexp(double(arg &"
+            " 1023), -24)\n";
+    file << "                                    : exp == 31 ? HUGE_VAL\n";
+    file << "                                    : std::ldexp(double((arg &"
+            " 1023) | 1024),\n";
+    file << "                                                 exp - 25);\n";
+    file << "                return arg >> 15 ? -res : res;\n";
+    file << "            }\n";
+    file << "            case 26 : {\n";
+    file << "                auto bits = uint32_t(arg);\n";
+    file << "                float res;\n";
+    file << "                std::memcpy(&res, &bits, sizeof(res));\n";
+    file << "                return double(res);\n";
+    file << "            }\n";
+    file << "            case 27 : {\n";
+    file << "                double res;\n";
+    file << "                std::memcpy(&res, &arg, sizeof(res));\n";
+    file << "                return res;\n";
+    file << "            }\n";
+    file << "            default :\n";
+    file << "                return fallback;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    bool as_bool(bool fallback = false) const\n";
+    file << "    {\n";
+    file << "        return type() == boolean ? (*m_data & 31) == 21 :"
+            " fallback;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "private:\n";
+    file << "    // the major type and the argument of the head at 'p', 'next'"
+            " past it\n";
+    file << "    bool head(unsigned char const* p, unsigned& major, uint64_t&"
+            " arg,\n";
+    file << "              unsigned char const*& next) const\n";
+    file << "    {\n";
+    file << "        if (!p || p >= m_end) {\n";
+    file << "            return false;\n";
+    file << "        }\n";
+    file << "        major = *p >> 5;\n";
+    file << "        unsigned info = *p & 31;\n";
+    file << "        if (info < 24) {\n";
+    file << "            arg = info;\n";
+    file << "            next = p + 1;\n";
+    file << "            return true;\n";
+    file << "        }\n";
+    file << "        if (info > 27) {\n";
+    file << "            return false;\n";
+    file << "        }\n";
+    file << "        std::size_t count = std::size_t(1) << (info - 24);\n";
+    file << "        if (std::size_t(m_end - p) <= count) {\n";
+    file << "            return false;\n";
+    file << "        }\n";
+    file << "        arg = 0;\n";
+    file << "        for (std::size_t i = 1; i <= count; ++i) {\n";
+    file << "            arg = arg << 8 | p[i];\n";
+    file << "        }\n";
+    file << "        next = p + 1 + count;\n";
+    file << "        return true;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // the first element of an array (4) or key of a map (5)\n";
+    file << "    cbor content(unsigned expected) const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (!head(m_data, major, arg, next) || major != expected)"
+            " {\n";
+    file << "            return cbor();\n";
+    file << "        }\n";
+    file << "        return at(next);\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // the item after this one\n";
+    file << "    cbor next() const\n";
+    file << "    {\n";
+    file << "        return at(skip(m_data, 0));\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    cbor at(unsigned char const* p) const\n";
+    file << "    {\n";
+    file << "        cbor res;\n";
+    file << "        if (p && p < m_end) {\n";
+    file << "            res.m_data = p;\n";
+    file << "            res.m_end = m_end;\n";
+    file << "        }\n";
+    file << "        return res;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    // pointer past the item at 'p', nullptr if it is malformed\n";
+    file << "    unsigned char const* skip(unsigned char const* p, int depth)"
+            " const\n";
+    file << "    {\n";
+    file << "        unsigned major = 0;\n";
+    file << "        uint64_t arg = 0;\n";
+    file << "        unsigned char const* next = nullptr;\n";
+    file << "        if (depth > 256 || !head(p, major, arg, next)) {\n";
+    file << "            return nullptr;\n";
+    file << "        }\n";
+    file << "        switch (major) {\n";
+    file << "            case 2 :\n";
+    file << "            case 3 :\n";
+    file << "                return uint64_t(m_end - next) < arg ? nullptr :"
+            " next + arg;\n";
+    file << "            case 4 :\n";
+    file << "            case 5 :\n";
+    file << "                for (uint64_t i = 0, n = major == 5 ? arg * 2 :"
+            " arg; i < n;\n";
+    file << "                     ++i) {\n";
+    file << "                    next = skip(next, depth + 1);\n";
+    file << "                    if (!next) {\n";
+    file << "                        return nullptr;\n";
+    file << "                    }\n";
+    file << "                }\n";
+    file << "                return next;\n";
+    file << "            case 6 :\n";
+    file << "                return skip(next, depth + 1);\n";
+    file << "            default :\n";
+    file << "                return next;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    unsigned char const* m_data;\n";
+    file << "    unsigned char const* m_end;\n";
+    file << "};\n";
+    file << "}  // namespace cpp_generes\n";
+    file << "#endif  // CPP_GENERES_CBOR_\n";
+}
+
+// whether any resource goes through the 'cbor' filter
+inline bool
+_has_cbor(Options const& options)
+{
+    for (auto const& filter : options.filters) {
+        if (filter.second == "cbor") {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the view of the CBOR resources, brought into the generated namespace
+// a module interface names the view with an alias, that is exported in its
+// own right, while the class stays in the global module
+inline void
+_write_cbor_using(std::ostream& file,
+                  Options const& options,
+                  bool is_module = false)
+{
+    if (_has_cbor(options) && options.name_space != "cpp_generes") {
+        if (is_module) {
+            file << "using cbor = ::cpp_generes::cbor;\n";
+        } else {
+            file << "using ::cpp_generes::cbor;\n";
+        }
+        file << "\n";
+    }
+}
+
+inline std::vector<std::size_t>
+_sorted_by_alias(std::vector<Resource> const& resources)
+{
+    std::vector<std::size_t> res;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        res.push_back(i);
+    }
+    std::sort(res.begin(), res.end(),
+              [&resources] (std::size_t lhs, std::size_t rhs)
+    { return resources[lhs].alias < resources[rhs].alias; });
+    return res;
+}
+
+// unique identifiers derived from the aliases, in resource order
+inline std::vector<std::string>
+_identifiers(std::vector<Resource> const& resources)
+{
+    std::vector<std::string> res;
+    std::set<std::string> used;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        auto id = _identifier(resources[i].alias);
+        if (used.count(id) != 0) {
+            id += "_" + std::to_string(i);
+        }
+        used.insert(id);
+        res.push_back(id);
+    }
+    return res;
+}
+
+// path of the file behind 'resource' as written into the generated code:
+// relative to --relative-to (if given) for the assembler and development
+// mode, that look in their working directories, otherwise relative to the
+// output, that #embed and development mode look next to; absolute only for
+// the standard output
+inline std::string
+_emitted_path(Options const& options,
+              Resource const& resource,
+              bool is_included = false)
+{
+    auto base = options.relative_to;
+    if ((is_included || base.empty()) && options.output != "-") {
+        base = _directory_name(options.output);
+        base = base.empty() ? "." : base;
+    }
+    if (base.empty()) {
+        return _replace(resource.file, '\\', "/");
+    }
+    auto dir = _absolute_path(base);
+    auto const is_absolute = (!dir.empty() && (dir[0] == '/' || dir[0] == '\\'))
+            || (dir.size() > 1 && dir[1] == ':');
+    if (!is_absolute) {
+        // the output directory isn't created yet
+        dir = _absolute_path(".") + "/" + dir;
+    }
+    return _relative_path(resource.file, dir);
+}
+
+inline void
+_write_entry(std::ostream& file, std::string const& name)
+{
+    file << "struct " << name << "_entry\n";
+    file << "{\n";
+    file << "    unsigned char const* data;\n";
+    file << "    std::size_t size;\n";
+    file << "};\n";
+}
+
+inline std::string
+_object_symbol(Options const& options, std::string const& id)
+{
+    return "_binary_" + options.name + "_" + id;
+}
+
+// names of the arrays or linker symbols holding the resource data
+inline std::vector<std::string>
+_symbols(Options const& options, std::vector<Resource> const& resources)
+{
+    auto const ids = _identifiers(resources);
+    std::vector<std::string> res;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        if (resources[i].mode == "object") {
+            res.push_back(_object_symbol(options, ids[i]) + "_start");
+        } else if (resources[i].mode == "incbin") {
+            res.push_back("_cpp_generes_" + _identifier(options.name_space)
+                          + "_" + options.name + "_" + ids[i]);
+        } else if (options.lang == "c") {
+            res.push_back(options.name + "_" + ids[i]);
+        } else {
+            res.push_back("_" + options.name + "_" + std::to_string(i));
+        }
+    }
+    return res;
+}
+
+// x86-64 small code model reaches 2 GiB with 32-bit relocations, data past
+// that goes to large sections; compilers can't handle bigger initializers
+uint64_t const large_size = uint64_t(1) << 31;
+
+inline bool
+_is_chunked(Options const& options, Resource const& resource)
+{
+    return resource.mode == "array" && resource.type.empty()
+            && options.chunk_size != 0 && resource.size > options.chunk_size;
+}
+
+// one struct of fixed-size arrays instead of a single huge initializer:
+// members of the same type are laid out without padding, so the chunks are
+// contiguous and the struct can be read as one byte array
+inline void
+_write_chunks(Output& file,
+              Options const& options,
+              Resource const& resource,
+              std::string const& symbol)
+{
+    auto const is_c = options.lang == "c";
+    auto const pieces = _split_encoded(resource.encoded, options.chunk_size);
+    file << (is_c ? "static const struct\n" : "static struct\n");
+    file << "{\n";
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+        auto size = std::min<uint64_t>(options.chunk_size,
+                                       resource.size - i * options.chunk_size);
+        file << (is_c ? "    unsigned char _" : "    uint8_t _") << i << "["
+             << size << "];\n";
+    }
+    file << (is_c ? "} " : "} const ") << symbol << "_chunks =\n";
+    file << "{\n";
+    for (auto const& piece : pieces) {
+        file << "    { ";
+        file.splice(resource.encoded, piece.first, piece.second);
+        file << " },\n";
+    }
+    file << "};\n";
+    if (is_c) {
+        file << "const unsigned char* const " << symbol
+             << " = (const unsigned char*)&" << symbol << "_chunks;\n";
+    } else {
+        file << "static_assert(sizeof(" << symbol << "_chunks) == "
+             << resource.size << ", \"chunks must be contiguous\");\n";
+        file << "static uint8_t const* const " << symbol << "\n";
+        file << "        = reinterpret_cast<uint8_t const*>(&" << symbol
+             << "_chunks);\n";
+    }
+}
+
+// data is reached through a pointer variable rather than an array
+inline bool
+_is_pointer(Options const& options, Resource const& resource)
+{
+    return _is_chunked(options, resource) || resource.mode == "words"
+            || !resource.type.empty();
+}
+
+// expression for the data pointer usable in a constant initializer
+inline std::string
+_data_expression(Options const& options,
+                 Resource const& resource,
+                 std::string const& symbol)
+{
+    if (options.lang != "c" || !_is_pointer(options, resource)) {
+        return symbol;
+    }
+    if (!resource.type.empty()) {
+        return "(const unsigned char*)" + symbol + "_elements";
+    }
+    if (resource.mode == "words") {
+        return "(const unsigned char*)" + symbol + "_words";
+    }
+    return "(const unsigned char*)&" + symbol + "_chunks";
+}
+
+inline void
+_write_incbin(std::ostream& file,
+              Options const& options,
+              Resource const& resource,
+              std::string const& symbol,
+              std::string const& section,
+              std::string const& flags)
+{
+    // archive entries are taken from the archive in place
+    auto range = std::string();
+    if (!resource.member.name.empty()) {
+        range = ", " + std::to_string(resource.member.offset) + ", "
+                + std::to_string(resource.size);
+    }
+    // a COMDAT group, so a header included by many units defines it once
+    std::string const lines[] =
+    {
+        ".pushsection " + section + "." + symbol + ",\"" + flags
+            + "\",%progbits," + symbol + ",comdat",
+        ".globl " + symbol,
+        ".type " + symbol + ", %object",
+        ".balign 16",
+        symbol + ":",
+        ".incbin \"" + _escape(_emitted_path(options, resource)) + "\""
+            + range,
+        ".size " + symbol + ", . - " + symbol,
+        ".popsection",
+    };
+    file << "__asm__(\n";
+    for (auto const& line : lines) {
+        file << "    \"" << _escape(line) << "\\n\"\n";
+    }
+    file << ");\n";
+}
+
+inline void
+_write_incbin(std::ostream& file,
+              Options const& options,
+              Resource const& resource,
+              std::string const& symbol)
+{
+    if (resource.size < large_size) {
+        _write_incbin(file, options, resource, symbol, ".rodata", "aG");
+        return;
+    }
+    file << "#if defined(__x86_64__)\n";
+    _write_incbin(file, options, resource, symbol, ".lrodata", "alG");
+    file << "#else\n";
+    _write_incbin(file, options, resource, symbol, ".rodata", "aG");
+    file << "#endif  // __x86_64__\n";
+}
+
+// bound for extern declarations of linker-provided data, a complete type
+// lets the compiler address large objects correctly in the medium model
+inline std::string
+_extern_bound(Resource const& resource)
+{
+    if ((resource.mode == "object" || resource.mode == "incbin")
+            && resource.size != 0) {
+        return "[" + std::to_string(resource.size) + "]";
+    }
+    return "[]";
+}
+
+// definition of the data of one resource in the emission mode it resolved to
+inline void
+_write_data(Output& file,
+            Options const& options,
+            Resource const& resource,
+            std::string const& symbol)
+{
+    auto const is_c = options.lang == "c";
+    auto const type = is_c ? "const unsigned char " : "static uint8_t const ";
+    auto const& mode = resource.mode;
+    if (mode == "object" || mode == "incbin") {
+        if (!is_c) {
+            file << "extern \"C\" unsigned char const " << symbol
+                 << _extern_bound(resource) << ";\n";
+        }
+        if (mode == "incbin") {
+            _write_incbin(file, options, resource, symbol);
+        }
+    } else if (!resource.type.empty()) {
+        // typed and aligned, the bytes are read through a pointer
+        auto const element = _element_name(resource.type, is_c);
+        if (is_c) {
+            file << "const " << element << " " << symbol << "_elements[] = { ";
+            file.splice(resource.encoded);
+            file << " };\n";
+            file << "const unsigned char* const " << symbol
+                 << " = (const unsigned char*)" << symbol << "_elements;\n";
+        } else {
+            file << "static constexpr " << element << " " << symbol
+                 << "_elements[] = { ";
+            file.splice(resource.encoded);
+            file << " };\n";
+            file << "static uint8_t const* const " << symbol << "\n";
+            file << "        = reinterpret_cast<uint8_t const*>(" << symbol
+                 << "_elements);\n";
+        }
+    } else if (_is_chunked(options, resource)) {
+        _write_chunks(file, options, resource, symbol);
+    } else if (mode == "string" || mode == "raw" || mode == "raw-utf8") {
+        file << type << symbol << "[" << resource.size + 1 << "] =\n";
+        file << "    ";
+        file.splice(resource.encoded);
+        file << ";\n";
+    } else if (mode == "words") {
+        file << "#if defined(__BYTE_ORDER__) "
+                "&& __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__\n";
+        file << "#error \"'words' mode data is packed for little-endian"
+                " targets\"\n";
+        file << "#endif\n";
+        if (is_c) {
+            file << "static const unsigned long long " << symbol
+                 << "_words[] = { ";
+            file.splice(resource.encoded);
+            file << " };\n";
+            file << "const unsigned char* const " << symbol
+                 << " = (const unsigned char*)" << symbol << "_words;\n";
+        } else {
+            file << "static uint64_t const " << symbol << "_words[] = { ";
+            file.splice(resource.encoded);
+            file << " };\n";
+            file << "static uint8_t const* const " << symbol << "\n";
+            file << "        = reinterpret_cast<uint8_t const*>(" << symbol
+                 << "_words);\n";
+        }
+    } else if (mode == "embed") {
+        file << type << symbol << "[] =\n";
+        file << "{\n";
+        // header names have no escapes, _resolve_modes checks the path
+        file << "#embed \"" << _emitted_path(options, resource, true)
+             << "\"\n";
+        file << "};\n";
+    } else {
+        // a NUL past the size, so that text can go to C APIs as it is
+        file << type << symbol << "[" << resource.size + 1 << "] = { ";
+        file.splice(resource.encoded);
+        file << " };\n";
+    }
+}
+
+inline void
+_write_arrays(Output& file,
+              Options const& options,
+              std::vector<Resource> const& resources)
+{
+    auto const symbols = _symbols(options, resources);
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        _write_data(file, options, resources[i], symbols[i]);
+    }
+}
+
+// data that is only in memory at generation time (typed, filtered, from
+// the standard input, deflated, ...) has no file to serve, it is embedded
+// as it is and doesn't reload
+inline void
+_write_dev_lookup(Output& file,
+                  Options const& options,
+                  std::vector<Resource> const& resources,
+                  std::string const& specifier)
+{
+    auto const& name = options.name;
+    auto const entry = name + "_entry";
+    auto const symbols = _symbols(options, resources);
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        if (_is_in_memory(resources[i])) {
+            _write_data(file, options, resources[i], symbols[i]);
+        }
+    }
+    file << "static inline std::unordered_map<std::string, " << entry
+         << "> const&\n";
+    file << "_" << name << "_embedded()\n";
+    file << "{\n";
+    file << "    static std::unordered_map<std::string, " << entry
+         << "> const embedded =\n";
+    file << "    {\n";
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        if (_is_in_memory(resources[i])) {
+            file << "        { \"" << _escape(resources[i].alias) << "\", { "
+                 << _data_expression(options, resources[i], symbols[i])
+                 << ", " << resources[i].size << "u } },\n";
+        }
+    }
+    file << "    };\n";
+    file << "    return embedded;\n";
+    file << "}\n";
+    file << "\n";
+    // without --relative-to the paths are relative to the generated file
+    auto const is_rooted = options.relative_to.empty()
+            && options.output != "-";
+    file << "static inline std::unordered_map<std::string, std::string>"
+            " const&\n";
+    file << "_" << name << "_paths()\n";
+    file << "{\n";
+    if (is_rooted) {
+        file << "    // relative to the directory of this file as the"
+                " compiler named it, so to\n";
+        file << "    // where it ran if that is relative, or to"
+                " CPP_GENERES_ROOT if it is defined\n";
+        file << "#if defined(CPP_GENERES_ROOT)\n";
+        file << "    static std::string const root"
+                " = std::string(CPP_GENERES_ROOT) + \"/\";\n";
+        file << "#else\n";
+        file << "    static std::string const root = [] ()\n";
+        file << "    {\n";
+        file << "        std::string res = __FILE__;\n";
+        file << "        return res.substr(0, res.find_last_of(\"/\\\\\")"
+                " + 1);\n";
+        file << "    }();\n";
+        file << "#endif  // CPP_GENERES_ROOT\n";
+    }
+    file << "    static std::unordered_map<std::string, std::string> const"
+            " paths =\n";
+    file << "    {\n";
+    bool has_ranges = false;
+    for (auto const& res : resources) {
+        if (!_is_in_memory(res)) {
+            auto const path = _emitted_path(options, res);
+            auto const is_absolute = (!path.empty() && path[0] == '/')
+                    || (path.size() > 1 && path[1] == ':');
+            file << "        { \"" << _escape(res.alias) << "\", "
+                 << (is_rooted && !is_absolute ? "root + " : "") << "\""
+                 << _escape(path) << "\" },\n";
+            has_ranges = has_ranges || !res.member.name.empty();
+        }
+    }
+    file << "    };\n";
+    file << "    return paths;\n";
+    file << "}\n";
+    file << "\n";
+    if (has_ranges) {
+        file << "static inline std::unordered_map<std::string,"
+                " std::pair<std::size_t, std::size_t> > const&\n";
+        file << "_" << name << "_ranges()\n";
+        file << "{\n";
+        file << "    static std::unordered_map<std::string,"
+                " std::pair<std::size_t, std::size_t> > const ranges =\n";
+        file << "    {\n";
+        for (auto const& res : resources) {
+            if (!_is_in_memory(res) && !res.member.name.empty()) {
+                file << "        { \"" << _escape(res.alias) << "\", { "
+                     << res.member.offset << "u, " << res.size << "u } },\n";
+            }
+        }
+        file << "    };\n";
+        file << "    return ranges;\n";
+        file << "}\n";
+        file << "\n";
+    }
+    file << "// returns the current contents of the file behind 'alias',"
+            " the embedded\n";
+    file << "// contents if it has none, or { nullptr, 0 }\n";
+    file << specifier << entry << "\n";
+    file << name << "_get(char const* alias)\n";
+    file << "{\n";
+    file << "    auto const& paths = _" << name << "_paths();\n";
+    file << "    auto it = paths.find(alias);\n";
+    file << "    if (it == paths.end()) {\n";
+    file << "        auto const& embedded = _" << name << "_embedded();\n";
+    file << "        auto data = embedded.find(alias);\n";
+    file << "        return data == embedded.end() ? " << entry
+         << "{ nullptr, 0 }\n";
+    file << std::string(39, ' ') << ": data->second;\n";
+    file << "    }\n";
+    file << "    auto blob = ::cpp_generes::dev::registry::instance()"
+            ".load(it->second);\n";
+    if (has_ranges) {
+        // archive entries are served from the mapping of the archive
+        file << "    auto const& ranges = _" << name << "_ranges();\n";
+        file << "    auto range = ranges.find(alias);\n";
+        file << "    if (range != ranges.end()) {\n";
+        file << "        auto end = range->second.first"
+                " + range->second.second;\n";
+        file << "        if (!blob.first || blob.second < end) {\n";
+        file << "            return " << entry << "{ nullptr, 0 };\n";
+        file << "        }\n";
+        file << "        return " << entry << "{ blob.first"
+                " + range->second.first, range->second.second };\n";
+        file << "    }\n";
+    }
+    file << "    return " << entry << "{ blob.first, blob.second };\n";
+    file << "}\n";
+}
+
+inline void
+_write_lookup(std::ostream& file,
+              Options const& options,
+              std::vector<Resource> const& resources,
+              std::string const& specifier)
+{
+    auto const& name = options.name;
+    auto const entry = name + "_entry";
+    auto const symbols = _symbols(options, resources);
+    file << "// returns the embedded contents of 'alias' or { nullptr, 0 }\n";
+    file << specifier << entry << "\n";
+    file << name << "_get(char const* alias)\n";
+    file << "{\n";
+    file << "    struct item\n";
+    file << "    {\n";
+    file << "        char const* alias;\n";
+    file << "        " << entry << " entry;\n";
+    file << "    };\n";
+    file << "    static item const table[] =\n";
+    file << "    {\n";
+    for (auto i : _sorted_by_alias(resources)) {
+        file << "        { \"" << _escape(resources[i].alias) << "\", { "
+             << symbols[i] << ", " << resources[i].size << " } },\n";
+    }
+    if (resources.empty()) {
+        file << "        { \"\", { nullptr, 0 } },\n";
+    }
+    file << "    };\n";
+    file << "    std::size_t lo = 0;\n";
+    file << "    std::size_t hi = " << resources.size() << ";\n";
+    file << "    while (lo < hi) {\n";
+    file << "        auto mid = lo + (hi - lo) / 2;\n";
+    file << "        auto cmp = std::strcmp(table[mid].alias, alias);\n";
+    file << "        if (cmp == 0) {\n";
+    file << "            return table[mid].entry;\n";
+    file << "        }\n";
+    file << "        if (cmp < 0) {\n";
+    file << "            lo = mid + 1;\n";
+    file << "        } else {\n";
+    file << "            hi = mid;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    return " << entry << "{ nullptr, 0 };\n";
+    file << "}\n";
+}
+
+// streaming access, for consumers that can't take the data at once
+inline void
+_write_read_accessor(std::ostream& file,
+                     Options const& options,
+                     std::string const& specifier,
+                     bool is_declaration)
+{
+    auto const is_c = options.lang == "c";
+    auto const& name = options.name;
+    if (is_declaration) {
+        file << "// copies up to 'size' bytes of 'alias' from 'offset' into"
+                " 'buffer',\n";
+        file << "// returns the number of bytes copied\n";
+        file << (is_c ? "size_t " : "std::size_t ") << name
+             << (is_c ? "_read(const char* alias" : "_read(char const* alias")
+             << ", unsigned long long offset,\n";
+        file << std::string(name.size() + (is_c ? 12 : 17), ' ')
+             << "void* buffer, " << (is_c ? "size_t" : "std::size_t")
+             << " size);\n";
+        return;
+    }
+    file << "// copies up to 'size' bytes of 'alias' from 'offset' into"
+            " 'buffer',\n";
+    file << "// returns the number of bytes copied\n";
+    file << specifier << (is_c ? "size_t\n" : "std::size_t\n");
+    file << name
+         << (is_c ? "_read(const char* alias" : "_read(char const* alias")
+         << ", unsigned long long offset,\n";
+    file << std::string(name.size() + 6, ' ') << "void* buffer, "
+         << (is_c ? "size_t" : "std::size_t") << " size)\n";
+    file << "{\n";
+    if (is_c) {
+        file << "    " << name << "_entry entry = " << name
+             << "_get(alias);\n";
+        file << "    if (entry.data == NULL || offset >= entry.size) {\n";
+    } else {
+        file << "    auto entry = " << name << "_get(alias);\n";
+        file << "    if (!entry.data || offset >= entry.size) {\n";
+    }
+    file << "        return 0;\n";
+    file << "    }\n";
+    file << "    if (size > entry.size - offset) {\n";
+    file << (is_c ? "        size = (size_t)(entry.size - offset);\n"
+                  : "        size = static_cast<std::size_t>(entry.size"
+                    " - offset);\n");
+    file << "    }\n";
+    file << (is_c ? "    memcpy(buffer, entry.data + offset, size);\n"
+                  : "    std::memcpy(buffer, entry.data + offset, size);\n");
+    file << "    return size;\n";
+    file << "}\n";
+}
+
+inline void
+_write_file_type(std::ostream& file, std::string const& name)
+{
+    file << "// bytes of a resource stored as they are in a file, for"
+            " sendfile or splice;\n";
+    file << "// 'fd' belongs to the program and is -1 if they are only in"
+            " memory\n";
+    file << "struct " << name << "_file\n";
+    file << "{\n";
+    file << "    int fd;\n";
+    file << "    unsigned long long offset;\n";
+    file << "    std::size_t size;\n";
+    file << "};\n";
+}
+
+inline void
+_write_iovec_comment(std::ostream& file, Options const& options)
+{
+    file << "// fills 'vec' with up to 'count' segments of the contents of"
+            " 'alias', of at\n";
+    file << "// most " << (options.chunk_size != 0 ? options.chunk_size
+                                                    : 0x7ffff000u)
+         << " bytes each, for writev, sendmsg or io_uring to read them in"
+            " place;\n";
+    file << "// returns the number of segments they take, 0 if there is no"
+            " such resource\n";
+}
+
+inline void
+_write_file_comment(std::ostream& file)
+{
+    file << "// returns where the contents of 'alias' are stored in a file,"
+            " { -1, 0, 0 } if\n";
+    file << "// there is no such file, then only _get and _get_iovec can"
+            " serve them\n";
+}
+
+// data handed to the kernel in place: segments of the embedded bytes and,
+// for sendfile, the file they were loaded from, that is the program or a
+// library, or the original file in development mode
+inline void
+_write_io_accessors(std::ostream& file,
+                    Options const& options,
+                    std::vector<Resource> const& resources,
+                    std::string const& specifier)
+{
+    auto const& name = options.name;
+    auto const none = name + "_file{ -1, 0, 0 }";
+    // the most Linux moves in one call, if the data isn't chunked
+    auto const segment = options.chunk_size != 0 ? options.chunk_size
+                                                 : 0x7ffff000u;
+    _write_iovec_comment(file, options);
+    file << specifier << "std::size_t\n";
+    file << name << "_get_iovec(char const* alias, iovec* vec,"
+            " std::size_t count)\n";
+    file << "{\n";
+    file << "    auto const entry = " << name << "_get(alias);\n";
+    file << "    std::size_t res = 0;\n";
+    file << "    for (std::size_t offset = 0; offset < entry.size;"
+            " ++res) {\n";
+    file << "        auto size = entry.size - offset;\n";
+    file << "        size = size < " << segment << "u ? size : " << segment
+         << "u;\n";
+    file << "        if (res < count) {\n";
+    file << "            vec[res].iov_base = const_cast<unsigned char*>"
+            "(entry.data + offset);\n";
+    file << "            vec[res].iov_len = size;\n";
+    file << "        }\n";
+    file << "        offset += size;\n";
+    file << "    }\n";
+    file << "    return res;\n";
+    file << "}\n";
+    file << "\n";
+    _write_file_comment(file);
+    file << specifier << name << "_file\n";
+    file << name << "_get_file(char const* alias)\n";
+    file << "{\n";
+    file << "#if defined(CPP_GENERES_DEVELOPMENT)\n";
+    bool has_ranges = false;
+    for (auto const& res : resources) {
+        has_ranges = has_ranges
+                || (!_is_in_memory(res) && !res.member.name.empty());
+    }
+    file << "    auto const& paths = _" << name << "_paths();\n";
+    file << "    auto it = paths.find(alias);\n";
+    file << "    if (it != paths.end()) {\n";
+    file << "        int fd = ::cpp_generes::io::files::instance()"
+            ".open(it->second);\n";
+    file << "        struct stat info;\n";
+    file << "        if (fd < 0 || ::fstat(fd, &info) != 0) {\n";
+    file << "            return " << none << ";\n";
+    file << "        }\n";
+    file << "        auto const size = static_cast<std::size_t>"
+            "(info.st_size);\n";
+    if (has_ranges) {
+        file << "        auto const& ranges = _" << name << "_ranges();\n";
+        file << "        auto range = ranges.find(alias);\n";
+        file << "        if (range != ranges.end()) {\n";
+        file << "            if (size < range->second.first"
+                " + range->second.second) {\n";
+        file << "                return " << none << ";\n";
+        file << "            }\n";
+        file << "            return " << name << "_file{ fd,"
+                " range->second.first,\n";
+        file << std::string(name.size() + 25, ' ')
+             << "range->second.second };\n";
+        file << "        }\n";
+    }
+    file << "        return " << name << "_file{ fd, 0, size };\n";
+    file << "    }\n";
+    file << "    // embedded, the data was only in memory when generated\n";
+    file << "#endif  // CPP_GENERES_DEVELOPMENT\n";
+    file << "    auto const entry = " << name << "_get(alias);\n";
+    file << "    if (!entry.data) {\n";
+    file << "        return " << none << ";\n";
+    file << "    }\n";
+    file << "    auto const res = ::cpp_generes::io::files::instance()"
+            ".image(entry.data,\n";
+    file << "                                                             "
+            "   entry.size);\n";
+    file << "    return " << name << "_file{ res.first, res.second,"
+            " res.first < 0 ? 0 : entry.size };\n";
+    file << "}\n";
+}
+
+// the zero-copy access of sources, with its type in a header
+inline void
+_write_io_definitions(std::ostream& file,
+                      Options const& options,
+                      std::vector<Resource> const& resources,
+                      std::string const& specifier,
+                      bool has_type)
+{
+    if (!options.zero_copy) {
+        return;
+    }
+    file << "\n";
+    file << "#if defined(__unix__) || defined(__APPLE__)\n";
+    if (has_type) {
+        _write_file_type(file, options.name);
+        file << "\n";
+    }
+    _write_io_accessors(file, options, resources, specifier);
+    file << "#endif  // __unix__ || __APPLE__\n";
+}
+
+// the zero-copy access of headers and interfaces that only declare it
+inline void
+_write_io_declarations(std::ostream& file, Options const& options)
+{
+    if (!options.zero_copy) {
+        return;
+    }
+    auto const& name = options.name;
+    file << "\n";
+    file << "#if defined(__unix__) || defined(__APPLE__)\n";
+    _write_file_type(file, name);
+    file << "\n";
+    _write_iovec_comment(file, options);
+    file << "std::size_t " << name << "_get_iovec(char const* alias,"
+            " iovec* vec,\n";
+    file << std::string(name.size() + 22, ' ') << "std::size_t count);\n";
+    file << "\n";
+    _write_file_comment(file);
+    file << name << "_file " << name << "_get_file(char const* alias);\n";
+    file << "#endif  // __unix__ || __APPLE__\n";
+}
+
+// whether any resource is typed
+inline bool
+_has_elements(Options const& options)
+{
+    for (auto const& input : options.inputs) {
+        if (!input.type.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// whether any resource is UTF-16 or UTF-32 text
+inline bool
+_has_text(Options const& options)
+{
+    for (auto const& input : options.inputs) {
+        if (_is_utf(input.type)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+char const* const cxx17_condition = "__cplusplus >= 201703L"
+        " || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)";
+
+// includes of the typed access, and the string views of text
+inline void
+_write_span_includes(std::ostream& file, Options const& options)
+{
+    file << "#include <type_traits>\n";
+    if (_has_text(options)) {
+        file << "#if " << cxx17_condition << "\n";
+        file << "#include <string_view>\n";
+        file << "#endif  // C++17+\n";
+    }
+}
+
+// <cmath> has the infinities and NaNs of typed data
+inline void
+_write_element_includes(std::ostream& file, Options const& options)
+{
+    file << "#include <cmath>\n";
+    _write_span_includes(file, options);
+}
+
+// element type of typed resources and a view of their elements
+inline void
+_write_element_types(std::ostream& file, Options const& options)
+{
+    auto const& name = options.name;
+    file << "// element type of a typed resource: 'f' (floating point), 'i'"
+            " (signed) or\n";
+    file << "// 'u' (unsigned integer) and its size in bytes\n";
+    file << "struct " << name << "_element\n";
+    file << "{\n";
+    file << "    char kind;\n";
+    file << "    std::size_t size;\n";
+    file << "};\n";
+    file << "\n";
+    file << "template <typename T>\n";
+    file << "struct " << name << "_span\n";
+    file << "{\n";
+    file << "    T const* data;\n";
+    file << "    std::size_t size;\n";
+    file << "\n";
+    file << "    T const* begin() const\n";
+    file << "    {\n";
+    file << "        return data;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    T const* end() const\n";
+    file << "    {\n";
+    file << "        return data + size;\n";
+    file << "    }\n";
+    file << "\n";
+    file << "    T const& operator[](std::size_t index) const\n";
+    file << "    {\n";
+    file << "        return data[index];\n";
+    file << "    }\n";
+    file << "};\n";
+}
+
+inline void
+_write_element_lookup(std::ostream& file,
+                      Options const& options,
+                      std::vector<Resource> const& resources,
+                      std::string const& specifier)
+{
+    auto const& name = options.name;
+    auto const element = name + "_element";
+    file << "// returns the element type of 'alias' or { 0, 0 } if it isn't"
+            " typed\n";
+    file << specifier << element << "\n";
+    file << name << "_type(char const* alias)\n";
+    file << "{\n";
+    file << "    struct item\n";
+    file << "    {\n";
+    file << "        char const* alias;\n";
+    file << "        " << element << " element;\n";
+    file << "    };\n";
+    file << "    static item const table[] =\n";
+    file << "    {\n";
+    bool is_empty = true;
+    for (auto const& res : resources) {
+        if (!res.type.empty()) {
+            file << "        { \"" << _escape(res.alias) << "\", { '"
+                 << res.type[0] << "', " << _element_size(res.type)
+                 << " } },\n";
+            is_empty = false;
+        }
+    }
+    if (is_empty) {
+        file << "        { \"\", { 0, 0 } },\n";
+    }
+    file << "    };\n";
+    file << "    for (auto const& it : table) {\n";
+    file << "        if (std::strcmp(it.alias, alias) == 0) {\n";
+    file << "            return it.element;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    return " << element << "{ 0, 0 };\n";
+    file << "}\n";
+}
+
+// the elements of typed data in place, with no conversion
+inline void
+_write_span_accessor(std::ostream& file,
+                     Options const& options,
+                     std::string const& specifier)
+{
+    auto const& name = options.name;
+    file << "// returns the elements of 'alias' or { nullptr, 0 } if it isn't"
+            " typed as T\n";
+    file << "template <typename T>\n";
+    file << specifier << name << "_span<T>\n";
+    file << name << "_get_span(char const* alias)\n";
+    file << "{\n";
+    file << "    auto const element = " << name << "_type(alias);\n";
+    file << "    auto const kind = std::is_floating_point<T>::value ? 'f'\n";
+    file << "                    : std::is_signed<T>::value ? 'i' : 'u';\n";
+    file << "    auto const entry = " << name << "_get(alias);\n";
+    file << "    if (!entry.data || element.kind != kind"
+            " || element.size != sizeof(T)) {\n";
+    file << "        return " << name << "_span<T>{ nullptr, 0 };\n";
+    file << "    }\n";
+    file << "    return " << name << "_span<T>{ reinterpret_cast<T const*>"
+            "(entry.data),\n";
+    file << std::string(name.size() + 21, ' ')
+         << "entry.size / sizeof(T) };\n";
+    file << "}\n";
+    if (!_has_text(options)) {
+        return;
+    }
+    std::pair<char const*, char const*> const views[] =
+    {
+        { "16", "UTF-16" }, { "32", "UTF-32" },
+    };
+    file << "\n";
+    file << "#if " << cxx17_condition << "\n";
+    for (auto const& view : views) {
+        if (&view != views) {
+            file << "\n";
+        }
+        file << "// returns the " << view.second << " text of 'alias' or an"
+                " empty view\n";
+        file << specifier << "std::u" << view.first << "string_view\n";
+        file << name << "_get_u" << view.first << "(char const* alias)\n";
+        file << "{\n";
+        file << "    auto const text = " << name << "_get_span<char"
+             << view.first << "_t>(alias);\n";
+        file << "    return std::u" << view.first
+             << "string_view(text.data, text.size);\n";
+        file << "}\n";
+    }
+    file << "#endif  // C++17+\n";
+}
+
+inline void
+_write_encoded_type(std::ostream& file, std::string const& name)
+{
+    file << "// contents of a resource in a content coding ('encoding' is"
+            " nullptr for the\n";
+    file << "// identity) with its entity tag and integrity hash, empty if"
+            " it has none\n";
+    file << "struct " << name << "_encoded\n";
+    file << "{\n";
+    file << "    unsigned char const* data;\n";
+    file << "    std::size_t size;\n";
+    file << "    char const* encoding;\n";
+    file << "    char const* etag;\n";
+    file << "    char const* integrity;\n";
+    file << "};\n";
+}
+
+inline void
+_write_encoded_comment(std::ostream& file)
+{
+    file << "// returns the contents of 'alias' in the coding that"
+            " 'accept_encoding' (the\n";
+    file << "// value of an Accept-Encoding header or nullptr) prefers, the"
+            " identity if\n";
+    file << "// none is acceptable, or { nullptr, 0, nullptr, \"\", \"\" }\n";
+}
+
+// development mode serves the files as they are, with no tags
+inline void
+_write_dev_encoded_lookup(std::ostream& file,
+                          Options const& options,
+                          std::string const& specifier)
+{
+    auto const& name = options.name;
+    _write_encoded_comment(file);
+    file << specifier << name << "_encoded\n";
+    file << name << "_get_encoded(char const* alias, char const*)\n";
+    file << "{\n";
+    file << "    auto const entry = " << name << "_get(alias);\n";
+    file << "    return " << name << "_encoded{ entry.data, entry.size,"
+            " nullptr, \"\", \"\" };\n";
+    file << "}\n";
+}
+
+// content negotiation over the variants made by --precompress
+inline void
+_write_encoded_lookup(std::ostream& file,
+                      Options const& options,
+                      std::vector<Resource> const& resources,
+                      std::string const& specifier)
+{
+    auto const& name = options.name;
+    auto const symbols = _symbols(options, resources);
+    std::map<std::string, std::size_t> indices;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        indices[resources[i].alias] = i;
+    }
+    file << "// weight of 'coding' in an Accept-Encoding header in"
+            " thousandths, that of '*'\n";
+    file << "// if it isn't listed, 'fallback' if neither is\n";
+    file << "static inline int\n";
+    file << "_" << name << "_quality(char const* header, char const* coding,"
+            " int fallback)\n";
+    file << "{\n";
+    file << "    int res = -1;\n";
+    file << "    int any = -1;\n";
+    file << "    for (auto p = header; *p != '\\0';) {\n";
+    file << "        while (*p == ' ' || *p == '\\t' || *p == ',') {\n";
+    file << "            ++p;\n";
+    file << "        }\n";
+    file << "        auto token = p;\n";
+    file << "        while (*p != '\\0' && *p != ',' && *p != ';'"
+            " && *p != ' '\n";
+    file << "               && *p != '\\t') {\n";
+    file << "            ++p;\n";
+    file << "        }\n";
+    file << "        auto length = std::size_t(p - token);\n";
+    file << "        // x-gzip and x-compress are the old names of gzip and"
+            " compress\n";
+    file << "        if (length > 2 && (*token == 'x' || *token == 'X')"
+            " && token[1] == '-') {\n";
+    file << "            token += 2;\n";
+    file << "            length -= 2;\n";
+    file << "        }\n";
+    file << "        auto is_coding = length == std::strlen(coding);\n";
+    file << "        for (std::size_t i = 0; is_coding && i < length; ++i)"
+            " {\n";
+    file << "            auto const c = token[i];\n";
+    file << "            is_coding = (c >= 'A' && c <= 'Z' ? char(c - 'A'"
+            " + 'a') : c)\n";
+    file << "                    == coding[i];\n";
+    file << "        }\n";
+    file << "        int weight = 1000;\n";
+    file << "        while (*p != '\\0' && *p != ',') {\n";
+    file << "            if (*p++ != ';') {\n";
+    file << "                continue;\n";
+    file << "            }\n";
+    file << "            while (*p == ' ' || *p == '\\t') {\n";
+    file << "                ++p;\n";
+    file << "            }\n";
+    file << "            if ((*p != 'q' && *p != 'Q') || p[1] != '=') {\n";
+    file << "                continue;\n";
+    file << "            }\n";
+    file << "            p += 2;\n";
+    file << "            weight = *p == '1' ? 1000 : 0;\n";
+    file << "            if (*p == '0' || *p == '1') {\n";
+    file << "                ++p;\n";
+    file << "            }\n";
+    file << "            if (*p == '.') {\n";
+    file << "                ++p;\n";
+    file << "            }\n";
+    file << "            for (int scale = 100; *p >= '0' && *p <= '9';"
+            " ++p, scale /= 10) {\n";
+    file << "                weight += (*p - '0') * scale;\n";
+    file << "            }\n";
+    file << "            weight = weight < 1000 ? weight : 1000;\n";
+    file << "        }\n";
+    file << "        if (length == 1 && *token == '*') {\n";
+    file << "            any = weight;\n";
+    file << "        } else if (is_coding) {\n";
+    file << "            res = weight;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    return res >= 0 ? res : any >= 0 ? any : fallback;\n";
+    file << "}\n";
+    file << "\n";
+    _write_encoded_comment(file);
+    file << specifier << name << "_encoded\n";
+    file << name << "_get_encoded(char const* alias,"
+            " char const* accept_encoding)\n";
+    file << "{\n";
+    file << "    struct variant\n";
+    file << "    {\n";
+    file << "        unsigned char const* data;\n";
+    file << "        std::size_t size;\n";
+    file << "        char const* etag;\n";
+    file << "    };\n";
+    file << "    struct item\n";
+    file << "    {\n";
+    file << "        char const* alias;\n";
+    file << "        char const* integrity;\n";
+    file << "        variant variants[3];\n";
+    file << "    };\n";
+    file << "    static char const* const codings[] = { nullptr, \"gzip\","
+            " \"br\" };\n";
+    file << "    static item const table[] =\n";
+    file << "    {\n";
+    std::size_t count = 0;
+    for (auto i : _sorted_by_alias(resources)) {
+        auto const& res = resources[i];
+        if (res.etag.empty() || !res.encoding.empty()) {
+            continue;
+        }
+        file << "        { \"" << _escape(res.alias) << "\", \""
+             << res.integrity << "\", {\n";
+        file << "            { " << symbols[i] << ", " << res.size << ", \""
+             << _escape(res.etag) << "\" },\n";
+        std::pair<char const*, char const*> const codings[] =
+        {
+            { "gzip", ".gz" }, { "br", ".br" },
+        };
+        for (auto const& coding : codings) {
+            auto it = indices.find(res.alias + coding.second);
+            if (it == indices.end()
+                    || resources[it->second].encoding != coding.first) {
+                file << "            { nullptr, 0, nullptr },\n";
+                continue;
+            }
+            auto const& variant = resources[it->second];
+            file << "            { " << symbols[it->second] << ", "
+                 << variant.size << ", \"" << _escape(variant.etag)
+                 << "\" },\n";
+        }
+        file << "        } },\n";
+        ++count;
+    }
+    if (count == 0) {
+        file << "        { \"\", \"\", { { nullptr, 0, nullptr },"
+                " { nullptr, 0, nullptr },\n";
+        file << "                    { nullptr, 0, nullptr } } },\n";
+    }
+    file << "    };\n";
+    file << "    std::size_t lo = 0;\n";
+    file << "    std::size_t hi = " << count << ";\n";
+    file << "    while (lo < hi) {\n";
+    file << "        auto mid = lo + (hi - lo) / 2;\n";
+    file << "        auto cmp = std::strcmp(table[mid].alias, alias);\n";
+    file << "        if (cmp < 0) {\n";
+    file << "            lo = mid + 1;\n";
+    file << "        } else {\n";
+    file << "            hi = mid;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    if (lo == " << count << " || std::strcmp(table[lo].alias,"
+            " alias) != 0) {\n";
+    file << "        auto const entry = " << name << "_get(alias);\n";
+    file << "        return " << name << "_encoded{ entry.data, entry.size,"
+            " nullptr, \"\", \"\" };\n";
+    file << "    }\n";
+    file << "    auto const& it = table[lo];\n";
+    file << "    auto const header = accept_encoding ? accept_encoding :"
+            " \"\";\n";
+    file << "    // the identity is acceptable unless excluded, but least"
+            " preferred, and\n";
+    file << "    // ties go to the smallest variant\n";
+    file << "    std::size_t best = 0;\n";
+    file << "    auto weight = _" << name << "_quality(header, \"identity\","
+            " 1);\n";
+    file << "    for (std::size_t i = 1; i < 3; ++i) {\n";
+    file << "        auto q = _" << name << "_quality(header, codings[i],"
+            " 0);\n";
+    file << "        if (it.variants[i].data && q > 0 && (q > weight\n";
+    file << "                || (q == weight && it.variants[i].size\n";
+    file << "                    < it.variants[best].size))) {\n";
+    file << "            best = i;\n";
+    file << "            weight = q;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    auto const& res = it.variants[best];\n";
+    file << "    return " << name << "_encoded{ res.data, res.size,"
+            " codings[best], res.etag,\n";
+    file << std::string(name.size() + 21, ' ') << "it.integrity };\n";
+    file << "}\n";
+}
+
+// the negotiated access of headers and interfaces that only declare it
+inline void
+_write_encoded_declarations(std::ostream& file, Options const& options)
+{
+    if (options.precompress.empty()) {
+        return;
+    }
+    file << "\n";
+    _write_encoded_type(file, options.name);
+    file << "\n";
+    _write_encoded_comment(file);
+    file << options.name << "_encoded " << options.name
+         << "_get_encoded(char const* alias,\n";
+    file << std::string(options.name.size() * 2 + 22, ' ')
+         << "char const* accept_encoding);\n";
+}
+
+// compile time maps between the aliases and the fingerprinted names, in
+// every layout as the callers need them in constant expressions; tables of
+// module interfaces have to be inline to be exported
+inline void
+_write_fingerprints(std::ostream& file,
+                    Options const& options,
+                    std::vector<Resource> const& resources,
+                    std::string const& specifier)
+{
+    if (options.fingerprints.empty()) {
+        return;
+    }
+    auto const& name = options.name;
+    std::vector<std::pair<std::string, std::string> > by_alias;
+    for (auto const& res : resources) {
+        if (!res.fingerprinted.empty()) {
+            by_alias.push_back(std::make_pair(res.alias, res.fingerprinted));
+        }
+    }
+    std::vector<std::pair<std::string, std::string> > by_fingerprint;
+    for (auto const& pair : by_alias) {
+        by_fingerprint.push_back(std::make_pair(pair.second, pair.first));
+    }
+    std::sort(by_alias.begin(), by_alias.end());
+    std::sort(by_fingerprint.begin(), by_fingerprint.end());
+    file << "\n";
+    file << "struct _" << name << "_names\n";
+    file << "{\n";
+    file << "    char const* key;\n";
+    file << "    char const* value;\n";
+    file << "};\n";
+    std::pair<char const*,
+              std::vector<std::pair<std::string, std::string> > const*> const
+            tables[] =
+    {
+        { "by_alias", &by_alias }, { "by_fingerprint", &by_fingerprint },
+    };
+    for (auto const& table : tables) {
+        file << "\n";
+        file << specifier << "constexpr _" << name << "_names _" << name
+             << "_" << table.first << "[] =\n";
+        file << "{\n";
+        for (auto const& pair : *table.second) {
+            file << "    { \"" << _escape(pair.first) << "\", \""
+                 << _escape(pair.second) << "\" },\n";
+        }
+        if (by_alias.empty()) {
+            file << "    { \"\", \"\" },\n";
+        }
+        file << "};\n";
+    }
+    file << "\n";
+    file << "// std::strcmp as a constant expression\n";
+    file << specifier << "constexpr int\n";
+    file << "_" << name << "_compare(char const* lhs, char const* rhs)\n";
+    file << "{\n";
+    file << "    return *lhs != *rhs ? (static_cast<unsigned char>(*lhs)\n";
+    file << "                           < static_cast<unsigned char>(*rhs)"
+            " ? -1 : 1)\n";
+    file << "            : *lhs == '\\0' ? 0 : _" << name
+         << "_compare(lhs + 1, rhs + 1);\n";
+    file << "}\n";
+    file << "\n";
+    file << "// binary search of 'key' in table[lo, hi)\n";
+    file << specifier << "constexpr char const*\n";
+    file << "_" << name << "_find(_" << name << "_names const* table,"
+            " char const* key,\n";
+    file << std::string(name.size() + 7, ' ')
+         << "std::size_t lo, std::size_t hi)\n";
+    file << "{\n";
+    file << "    return lo >= hi ? nullptr\n";
+    file << "            : _" << name << "_compare(table[lo + (hi - lo) / 2]"
+            ".key, key) < 0\n";
+    file << "            ? _" << name << "_find(table, key,"
+            " lo + (hi - lo) / 2 + 1, hi)\n";
+    file << "            : _" << name << "_compare(table[lo + (hi - lo) / 2]"
+            ".key, key) > 0\n";
+    file << "            ? _" << name << "_find(table, key, lo,"
+            " lo + (hi - lo) / 2)\n";
+    file << "            : table[lo + (hi - lo) / 2].value;\n";
+    file << "}\n";
+    std::pair<char const*, char const*> const lookups[] =
+    {
+        { "fingerprinted", "by_alias" }, { "logical", "by_fingerprint" },
+    };
+    for (auto const& lookup : lookups) {
+        file << "\n";
+        if (&lookup == lookups) {
+            file << "// returns the fingerprinted name of 'alias' or"
+                    " nullptr\n";
+            file << specifier << "constexpr char const*\n";
+            file << name << "_fingerprinted(char const* alias)\n";
+        } else {
+            file << "// returns the alias of a fingerprinted name or"
+                    " nullptr\n";
+            file << specifier << "constexpr char const*\n";
+            file << name << "_logical(char const* fingerprinted)\n";
+        }
+        file << "{\n";
+        file << "    return _" << name << "_find(_" << name << "_"
+             << lookup.second << ", "
+             << (&lookup == lookups ? "alias" : "fingerprinted") << ", 0, "
+             << by_alias.size() << ");\n";
+        file << "}\n";
+    }
+}
+
+// the typed access of headers and interfaces that only declare the lookups
+inline void
+_write_element_declarations(std::ostream& file, Options const& options)
+{
+    if (!_has_elements(options)) {
+        return;
+    }
+    file << "\n";
+    _write_element_types(file, options);
+    file << "\n";
+    file << "// returns the element type of 'alias' or { 0, 0 } if it isn't"
+            " typed\n";
+    file << options.name << "_element " << options.name
+         << "_type(char const* alias);\n";
+    file << "\n";
+    _write_span_accessor(file, options, "inline ");
+}
+
+inline void
+_write_resources(Output& file,
+                 Options const& options,
+                 std::vector<Resource> const& resources)
+{
+    auto const& name = options.name;
+    auto const map_type
+            = "std::unordered_map<std::string, std::vector<uint8_t> >";
+    auto const symbols = _symbols(options, resources);
+    _write_entry(file, name);
+    file << "\n";
+    if (!options.precompress.empty()) {
+        _write_encoded_type(file, name);
+        file << "\n";
+    }
+    file << "#if defined(CPP_GENERES_DEVELOPMENT)\n";
+    _write_dev_lookup(file, options, resources, "static inline ");
+    if (!options.precompress.empty()) {
+        file << "\n";
+        _write_dev_encoded_lookup(file, options, "static inline ");
+    }
+    file << "\n";
+    file << "// a copy taken when the program starts, that doesn't reload;"
+            " " << name << "_get\n";
+    file << "// serves the current contents\n";
+    file << "static " << map_type << " const " << name << " = [] ()\n";
+    file << "{\n";
+    file << "    " << map_type << " res;\n";
+    file << "    for (auto const& pair : _" << name << "_paths()) {\n";
+    file << "        auto entry = " << name << "_get(pair.first.c_str());\n";
+    file << "        if (entry.data) {\n";
+    file << "            res.emplace(pair.first, std::vector<uint8_t>(\n";
+    file << "                            entry.data, entry.data + entry.size));"
+            "\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    for (auto const& pair : _" << name << "_embedded()) {\n";
+    file << "        res.emplace(pair.first, std::vector<uint8_t>(\n";
+    file << "                        pair.second.data,"
+            " pair.second.data + pair.second.size));\n";
+    file << "    }\n";
+    file << "    return res;\n";
+    file << "}();\n";
+    file << "#else\n";
+    _write_arrays(file, options, resources);
+    file << "\n";
+    file << "static " << map_type << " const " << name << " =\n";
+    file << "{\n";
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        file << "    { \"" << _escape(resources[i].alias) << "\", { "
+             << symbols[i] << ", " << symbols[i] << " + "
+             << resources[i].size << " } },\n";
+    }
+    file << "};\n";
+    file << "\n";
+    _write_lookup(file, options, resources, "static inline ");
+    if (!options.precompress.empty()) {
+        file << "\n";
+        _write_encoded_lookup(file, options, resources, "static inline ");
+    }
+    file << "#endif  // CPP_GENERES_DEVELOPMENT\n";
+    file << "\n";
+    _write_read_accessor(file, options, "static inline ", false);
+    _write_io_definitions(file, options, resources, "static inline ", true);
+    if (_has_elements(options)) {
+        file << "\n";
+        _write_element_types(file, options);
+        file << "\n";
+        _write_element_lookup(file, options, resources, "static inline ");
+        file << "\n";
+        _write_span_accessor(file, options, "static inline ");
+    }
+    _write_fingerprints(file, options, resources, "static ");
+}
+
+// appends 'value' as a little-endian field of 'size' bytes
+inline void
+_put(std::string& out, uint64_t value, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+inline void
+_pad(std::string& out, std::size_t align)
+{
+    out.resize((out.size() + align - 1) / align * align, '\0');
+}
+
+inline std::string
+_host_arch()
+{
+#if defined(__aarch64__) || defined(_M_ARM64)
+    return "aarch64";
+#elif defined(__riscv) && __riscv_xlen == 64
+    return "riscv64";
+#elif defined(__powerpc64__) && defined(__LITTLE_ENDIAN__)
+    return "ppc64le";
+#else
+    return "x86_64";
+#endif  // arch
+}
+
+// relocatable ELF64 object with the same symbols 'ld -r -b binary' defines:
+// _binary_<name>_<alias>_start, _end and _size
+inline Content
+_generate_object(Options const& options, std::vector<Resource> const& resources)
+{
+    uint64_t machine = 62;
+    uint64_t flags = 0;
+    if (options.arch == "aarch64") {
+        machine = 183;
+    } else if (options.arch == "riscv64") {
+        machine = 243;
+        flags = 0x5;  // RVC, double-float ABI
+    } else if (options.arch == "ppc64le") {
+        machine = 21;
+        flags = 0x2;  // ELFv2 ABI
+    }
+    uint64_t const rodata_align = 16;
+
+    auto const ids = _identifiers(resources);
+    std::vector<std::pair<Resource const*, std::string> > layout;
+    uint64_t rodata_size = 0;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        if (resources[i].mode == "object") {
+            layout.push_back(std::make_pair(&resources[i],
+                                            _object_symbol(options, ids[i])));
+            rodata_size += resources[i].size;
+        }
+    }
+    // a section per resource, so that the linker places them on their own
+    // and --gc-sections drops the unused ones, unless the section indices
+    // would run out
+    auto const is_split = layout.size() < 0xff00 - 5;
+    // SHF_ALLOC, plus SHF_X86_64_LARGE in .lrodata for the medium model
+    auto const is_large = options.arch == "x86_64" && rodata_size >= large_size;
+    std::string const rodata_name = is_large ? ".lrodata" : ".rodata";
+    uint64_t const rodata_flags = is_large ? 0x10000002 : 0x2;
+
+    std::string strtab(1, '\0');
+    std::string symtab(24, '\0');
+    auto const add_symbol = [&strtab, &symtab]
+            (std::string const& name, uint64_t info, uint64_t section,
+             uint64_t value, uint64_t size)
+    {
+        _put(symtab, strtab.size(), 4);
+        _put(symtab, info, 1);
+        _put(symtab, 0, 1);
+        _put(symtab, section, 2);
+        _put(symtab, value, 8);
+        _put(symtab, size, 8);
+        strtab += name;
+        strtab += '\0';
+    };
+    std::string shstrtab(1, '\0');
+    auto const add_name = [&shstrtab] (std::string const& name)
+    {
+        auto res = shstrtab.size();
+        shstrtab += name;
+        shstrtab += '\0';
+        return res;
+    };
+
+    // file contents are referenced rather than read here, and are copied
+    // into the object file while it is written, a block at a time
+    Content res;
+    res.text.assign(64, '\0');
+    uint64_t written = res.text.size();
+    auto const pad = [&res, &written] (uint64_t align)
+    {
+        auto const size = (written + align - 1) / align * align - written;
+        res.text.append(static_cast<std::size_t>(size), '\0');
+        written += size;
+    };
+    // offset, size and name of each data section
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> sizes;
+    std::vector<std::size_t> names;
+    for (std::size_t i = 0; i < layout.size(); ++i) {
+        auto const& resource = *layout[i].first;
+        auto const& symbol = layout[i].second;
+        pad(rodata_align);
+        if (is_split || i == 0) {
+            offsets.push_back(written);
+            sizes.push_back(0);
+            names.push_back(add_name(is_split ? rodata_name + "." + symbol
+                                              : rodata_name));
+        }
+        auto const section = offsets.size();
+        auto const value = written - offsets.back();
+        uint64_t const size = resource.size;
+        // global object in the section, global absolute symbol for the size
+        add_symbol(symbol + "_start", 0x11, section, value, size);
+        add_symbol(symbol + "_end", 0x11, section, value + size, 0);
+        add_symbol(symbol + "_size", 0x10, 0xfff1, size, 0);
+
+        if (_is_in_memory(resource)) {
+            // read while resolving the modes
+            res.text.append(resource.data.begin(), resource.data.end());
+        } else {
+            Fragment fragment;
+            fragment.offset = res.text.size();
+            fragment.file = &resource.file;
+            fragment.begin = static_cast<std::size_t>(resource.member.offset);
+            fragment.size = static_cast<std::size_t>(size);
+            res.fragments.push_back(fragment);
+        }
+        written += size;
+        sizes.back() = written - offsets.back();
+    }
+    auto const symtab_index = add_name(".symtab");
+    auto const strtab_index = add_name(".strtab");
+    auto const shstrtab_index = add_name(".shstrtab");
+    auto const note_index = add_name(".note.GNU-stack");
+
+    pad(8);
+    uint64_t const symtab_offset = written;
+    uint64_t const strtab_offset = symtab_offset + symtab.size();
+    uint64_t const shstrtab_offset = strtab_offset + strtab.size();
+    res.text += symtab;
+    res.text += strtab;
+    res.text += shstrtab;
+    written = shstrtab_offset + shstrtab.size();
+    pad(8);
+    uint64_t const shoff = written;
+
+    auto const add_section = [&res]
+            (uint64_t name, uint64_t type, uint64_t sh_flags, uint64_t offset,
+             uint64_t size, uint64_t link, uint64_t info, uint64_t align,
+             uint64_t entsize)
+    {
+        _put(res.text, name, 4);
+        _put(res.text, type, 4);
+        _put(res.text, sh_flags, 8);
+        _put(res.text, 0, 8);
+        _put(res.text, offset, 8);
+        _put(res.text, size, 8);
+        _put(res.text, link, 4);
+        _put(res.text, info, 4);
+        _put(res.text, align, 8);
+        _put(res.text, entsize, 8);
+    };
+    add_section(0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for (std::size_t i = 0; i < offsets.size(); ++i) {
+        add_section(names[i], 1, rodata_flags, offsets[i], sizes[i], 0, 0,
+                    rodata_align, 0);
+    }
+    auto const count = offsets.size();
+    add_section(symtab_index, 2, 0, symtab_offset, symtab.size(), count + 2,
+                1, 8, 24);
+    add_section(strtab_index, 3, 0, strtab_offset, strtab.size(), 0, 0, 1, 0);
+    add_section(shstrtab_index, 3, 0, shstrtab_offset, shstrtab.size(), 0, 0,
+                1, 0);
+    add_section(note_index, 1, 0, shstrtab_offset, 0, 0, 0, 1, 0);
+
+    std::string header("\x7f" "ELF\x02\x01\x01", 7);
+    header.resize(16, '\0');
+    _put(header, 1, 2);
+    _put(header, machine, 2);
+    _put(header, 1, 4);
+    _put(header, 0, 8);
+    _put(header, 0, 8);
+    _put(header, shoff, 8);
+    _put(header, flags, 4);
+    _put(header, 64, 2);
+    _put(header, 0, 2);
+    _put(header, 0, 2);
+    _put(header, 64, 2);
+    _put(header, count + 5, 2);
+    _put(header, count + 3, 2);
+    res.text.replace(0, header.size(), header);
+    return res;
+}
+
+inline void
+_write_preamble(std::ostream& file, bool development = true)
+{
+    file << "// this file is auto-generated by the cpp-generes program\n";
+    file << "// see https://github.com/rue-ryuzaki/cpp-generes\n";
+    if (!development) {
+        file << "\n";
+        return;
+    }
+    file << "//\n";
+    file << "// define CPP_GENERES_DEVELOPMENT to serve resources from their"
+            " original\n";
+    file << "// files instead, reloading them on change without recompiling\n";
+    file << "\n";
+}
+
+inline Content
+_generate_header(Options const& options, std::vector<Resource> const& resources)
+{
+    Output file;
+    _write_preamble(file);
+    if (options.guards == "define") {
+        file << "#ifndef " + options.define + "\n";
+        file << "#define " + options.define + "\n";
+    } else {
+        file << "#pragma once\n";
+    }
+    file << "\n";
+    file << "#include <cstddef>\n";
+    file << "#include <cstdint>\n";
+    file << "#include <cstring>\n";
+    file << "#include <string>\n";
+    file << "#include <vector>\n";
+    file << "#include <unordered_map>\n";
+    if (_has_elements(options)) {
+        _write_element_includes(file, options);
+    }
+    file << "\n";
+    _write_dev_includes(file);
+    if (options.zero_copy) {
+        _write_io_includes(file);
+    }
+    _write_dev_runtime(file);
+    if (options.zero_copy) {
+        _write_io_runtime(file);
+    }
+    if (_has_cbor(options)) {
+        _write_cbor_view(file);
+    }
+    file << "\n";
+    file << "namespace " << options.name_space << " {\n";
+    _write_cbor_using(file, options);
+    _write_resources(file, options, resources);
+    file << "}  // namespace " << options.name_space << "\n";
+    if (options.guards == "define") {
+        file << "\n";
+        file << "#endif  // " + options.define + "\n";
+    }
+    return file.content();
+}
+
+// declarations only, so that including it costs next to nothing; only the
+// fingerprints, if any, depend on the contents
+inline Content
+_generate_api_header(Options const& options,
+                     std::vector<Resource> const& resources)
+{
+    Output file;
+    _write_preamble(file);
+    if (options.guards == "define") {
+        file << "#ifndef " + options.define + "\n";
+        file << "#define " + options.define + "\n";
+    } else {
+        file << "#pragma once\n";
+    }
+    file << "\n";
+    file << "#include <cstddef>\n";
+    if (_has_elements(options)) {
+        _write_span_includes(file, options);
+    }
+    if (options.zero_copy) {
+        _write_io_includes(file, true);
+    }
+    file << "\n";
+    if (_has_cbor(options)) {
+        file << "// defined in \""
+             << _file_name(_source_path(options.output, "_cbor.hpp"))
+             << "\", for the callers that read it\n";
+        file << "namespace cpp_generes {\n";
+        file << "class cbor;\n";
+        file << "}  // namespace cpp_generes\n";
+        file << "\n";
+    }
+    file << "namespace " << options.name_space << " {\n";
+    _write_cbor_using(file, options);
+    _write_entry(file, options.name);
+    file << "\n";
+    file << "// returns the contents of 'alias' or { nullptr, 0 }\n";
+    file << options.name << "_entry " << options.name
+         << "_get(char const* alias);\n";
+    file << "\n";
+    _write_read_accessor(file, options, "", true);
+    _write_encoded_declarations(file, options);
+    _write_io_declarations(file, options);
+    _write_element_declarations(file, options);
+    _write_fingerprints(file, options, resources, "static ");
+    file << "}  // namespace " << options.name_space << "\n";
+    if (options.guards == "define") {
+        file << "\n";
+        file << "#endif  // " + options.define + "\n";
+    }
+    return file.content();
+}
+
+inline Content
+_generate_source(Options const& options, std::vector<Resource> const& resources)
+{
+    Output file;
+    _write_preamble(file);
+    file << "#include \"" << _file_name(options.output) << "\"\n";
+    file << "\n";
+    file << "#include <cstdint>\n";
+    file << "#include <cstring>\n";
+    file << "#include <string>\n";
+    file << "#include <vector>\n";
+    file << "#include <unordered_map>\n";
+    if (_has_elements(options)) {
+        file << "#include <cmath>\n";
+    }
+    file << "\n";
+    _write_dev_includes(file);
+    if (options.zero_copy) {
+        _write_io_includes(file);
+    }
+    _write_dev_runtime(file);
+    if (options.zero_copy) {
+        _write_io_runtime(file);
+    }
+    file << "\n";
+    file << "namespace " << options.name_space << " {\n";
+    file << "#if defined(CPP_GENERES_DEVELOPMENT)\n";
+    _write_dev_lookup(file, options, resources, "");
+    if (!options.precompress.empty()) {
+        file << "\n";
+        _write_dev_encoded_lookup(file, options, "");
+    }
+    file << "#else\n";
+    _write_arrays(file, options, resources);
+    file << "\n";
+    _write_lookup(file, options, resources, "");
+    if (!options.precompress.empty()) {
+        file << "\n";
+        _write_encoded_lookup(file, options, resources, "");
+    }
+    file << "#endif  // CPP_GENERES_DEVELOPMENT\n";
+    file << "\n";
+    _write_read_accessor(file, options, "", false);
+    _write_io_definitions(file, options, resources, "", false);
+    if (_has_elements(options)) {
+        file << "\n";
+        _write_element_lookup(file, options, resources, "");
+    }
+    file << "}  // namespace " << options.name_space << "\n";
+    return file.content();
+}
+
+// the CBOR view in a header of its own, for the global module fragment of
+// an interface unit, that can only take it from a header, and for the
+// callers of the split layout that read it
+inline Content
+_generate_cbor_header()
+{
+    Output file;
+    _write_preamble(file, false);
+    _write_cbor_view(file);
+    return file.content();
+}
+
+// interface unit with the accessor declarations
+inline Content
+_generate_module_interface(Options const& options,
+                           std::vector<Resource> const& resources)
+{
+    Output file;
+    _write_preamble(file);
+    file << "module;\n";
+    file << "\n";
+    file << "#include <cstddef>\n";
+    if (_has_elements(options)) {
+        _write_span_includes(file, options);
+    }
+    if (options.zero_copy) {
+        _write_io_includes(file, true);
+    }
+    if (_has_cbor(options)) {
+        file << "#include \""
+             << _file_name(_source_path(options.output, "_cbor.hpp"))
+             << "\"\n";
+    }
+    file << "\n";
+    file << "export module " << options.name << ";\n";
+    file << "\n";
+    file << "export namespace " << options.name_space << " {\n";
+    _write_cbor_using(file, options, true);
+    _write_entry(file, options.name);
+    file << "\n";
+    file << "// returns the contents of 'alias' or { nullptr, 0 }\n";
+    file << options.name << "_entry " << options.name
+         << "_get(char const* alias);\n";
+    file << "\n";
+    _write_read_accessor(file, options, "", true);
+    _write_encoded_declarations(file, options);
+    _write_io_declarations(file, options);
+    _write_element_declarations(file, options);
+    _write_fingerprints(file, options, resources, "inline ");
+    file << "}  // namespace " << options.name_space << "\n";
+    return file.content();
+}
+
+// implementation unit with the data, built once for all importers
+inline Content
+_generate_module_source(Options const& options,
+                        std::vector<Resource> const& resources)
+{
+    Output file;
+    _write_preamble(file);
+    file << "module;\n";
+    file << "\n";
+    file << "#include <cstddef>\n";
+    file << "#include <cstdint>\n";
+    file << "#include <cstring>\n";
+    file << "#include <string>\n";
+    file << "#include <vector>\n";
+    file << "#include <unordered_map>\n";
+    if (_has_elements(options)) {
+        file << "#include <cmath>\n";
+    }
+    file << "\n";
+    _write_dev_includes(file);
+    if (options.zero_copy) {
+        _write_io_includes(file);
+    }
+    file << "\n";
+    file << "module " << options.name << ";\n";
+    file << "\n";
+    _write_dev_runtime(file);
+    if (options.zero_copy) {
+        _write_io_runtime(file);
+    }
+    file << "\n";
+    file << "namespace " << options.name_space << " {\n";
+    file << "#if defined(CPP_GENERES_DEVELOPMENT)\n";
+    _write_dev_lookup(file, options, resources, "");
+    if (!options.precompress.empty()) {
+        file << "\n";
+        _write_dev_encoded_lookup(file, options, "");
+    }
+    file << "#else\n";
+    _write_arrays(file, options, resources);
+    file << "\n";
+    _write_lookup(file, options, resources, "");
+    if (!options.precompress.empty()) {
+        file << "\n";
+        _write_encoded_lookup(file, options, resources, "");
+    }
+    file << "#endif  // CPP_GENERES_DEVELOPMENT\n";
+    file << "\n";
+    _write_read_accessor(file, options, "", false);
+    _write_io_definitions(file, options, resources, "", false);
+    if (_has_elements(options)) {
+        file << "\n";
+        _write_element_lookup(file, options, resources, "");
+    }
+    file << "}  // namespace " << options.name_space << "\n";
+    return file.content();
+}
+
+inline Content
+_generate_c_header(Options const& options,
+                   std::vector<Resource> const& resources)
+{
+    auto const ids = _identifiers(resources);
+    auto const symbols = _symbols(options, resources);
+    auto const prefix = _to_upper(options.name);
+    Output file;
+    _write_preamble(file, false);
+    if (options.guards == "define") {
+        file << "#ifndef " + options.define + "\n";
+        file << "#define " + options.define + "\n";
+    } else {
+        file << "#pragma once\n";
+    }
+    file << "\n";
+    file << "#include <stddef.h>\n";
+    if (_has_elements(options)) {
+        file << "#include <stdint.h>\n";
+    }
+    file << "\n";
+    file << "#ifdef __cplusplus\n";
+    file << "extern \"C\" {\n";
+    file << "#endif  // __cplusplus\n";
+    file << "\n";
+    file << "typedef struct " << options.name << "_entry\n";
+    file << "{\n";
+    file << "    const unsigned char* data;\n";
+    file << "    size_t size;\n";
+    file << "} " << options.name << "_entry;\n";
+    file << "\n";
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        file << "// " << _escape(resources[i].alias) << "\n";
+        file << "#define " << prefix << "_" << _to_upper(ids[i])
+             << "_SIZE ((size_t)" << resources[i].size << "u)\n";
+        if (!resources[i].type.empty()) {
+            // typed elements, also read as bytes through the pointer
+            auto const& type = resources[i].type;
+            auto const count = resources[i].size / _element_size(type);
+            auto const bound = _is_utf(type) ? count + 1
+                                             : std::max<uint64_t>(count, 1);
+            file << "#define " << prefix << "_" << _to_upper(ids[i])
+                 << "_COUNT ((size_t)" << count << "u)\n";
+            file << "extern const " << _element_name(type, true) << " "
+                 << symbols[i] << "_elements[" << bound << "];\n";
+        }
+        if (_is_pointer(options, resources[i])) {
+            file << "extern const unsigned char* const " << symbols[i]
+                 << ";\n";
+        } else {
+            file << "extern const unsigned char " << symbols[i]
+                 << _extern_bound(resources[i]) << ";\n";
+        }
+    }
+    file << "\n";
+    file << "// returns the contents of 'alias' or { NULL, 0 }\n";
+    file << options.name << "_entry " << options.name
+         << "_get(const char* alias);\n";
+    file << "\n";
+    _write_read_accessor(file, options, "", true);
+    file << "\n";
+    file << "#ifdef __cplusplus\n";
+    file << "}  // extern \"C\"\n";
+    file << "#endif  // __cplusplus\n";
+    if (options.guards == "define") {
+        file << "\n";
+        file << "#endif  // " + options.define + "\n";
+    }
+    return file.content();
+}
+
+inline Content
+_generate_c_source(Options const& options,
+                   std::vector<Resource> const& resources)
+{
+    auto const symbols = _symbols(options, resources);
+    auto const entry = options.name + "_entry";
+    Output file;
+    _write_preamble(file, false);
+    file << "#include \"" << _file_name(options.output) << "\"\n";
+    file << "\n";
+    if (_has_elements(options)) {
+        file << "#include <math.h>\n";
+    }
+    file << "#include <string.h>\n";
+    file << "\n";
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        _write_data(file, options, resources[i], symbols[i]);
+    }
+    file << "\n";
+    file << entry << "\n";
+    file << options.name << "_get(const char* alias)\n";
+    file << "{\n";
+    file << "    static const struct\n";
+    file << "    {\n";
+    file << "        const char* alias;\n";
+    file << "        " << entry << " entry;\n";
+    file << "    } table[] =\n";
+    file << "    {\n";
+    for (auto i : _sorted_by_alias(resources)) {
+        file << "        { \"" << _escape(resources[i].alias) << "\", { "
+             << _data_expression(options, resources[i], symbols[i]) << ", "
+             << resources[i].size << "u } },\n";
+    }
+    if (resources.empty()) {
+        file << "        { \"\", { NULL, 0 } },\n";
+    }
+    file << "    };\n";
+    file << "    size_t lo = 0;\n";
+    file << "    size_t hi = " << resources.size() << "u;\n";
+    file << "    " << entry << " none = { NULL, 0 };\n";
+    file << "    while (lo < hi) {\n";
+    file << "        size_t mid = lo + (hi - lo) / 2;\n";
+    file << "        int cmp = strcmp(table[mid].alias, alias);\n";
+    file << "        if (cmp == 0) {\n";
+    file << "            return table[mid].entry;\n";
+    file << "        }\n";
+    file << "        if (cmp < 0) {\n";
+    file << "            lo = mid + 1;\n";
+    file << "        } else {\n";
+    file << "            hi = mid;\n";
+    file << "        }\n";
+    file << "    }\n";
+    file << "    return none;\n";
+    file << "}\n";
+    file << "\n";
+    _write_read_accessor(file, options, "", false);
+    return file.content();
+}
+
+// SHA-256 of the aliases, modes and data of the resources; data that isn't
+// in memory is streamed from its file
+inline std::string
+_content_hash(std::vector<Resource> const& resources)
+{
+    std::vector<std::string> hashes(resources.size());
+    _parallel_for(resources.size(), _hardware_threads(), [&] (std::size_t i)
+    {
+        auto const& resource = resources[i];
+        Sha256 hash;
+        if (resource.data.size() == resource.size) {
+            hash.update(resource.data.data(), resource.data.size());
+        } else if (!_is_in_memory(resource)) {
+            std::ifstream in(resource.file, std::ios::binary);
+            in.seekg(std::streamoff(resource.member.offset));
+            std::vector<char> buffer(1 << 20);
+            for (uint64_t left = resource.size; left != 0 && in; ) {
+                auto count = std::min<uint64_t>(left, buffer.size());
+                in.read(buffer.data(), std::streamsize(count));
+                hash.update(buffer.data(),
+                            static_cast<std::size_t>(in.gcount()));
+                left -= static_cast<uint64_t>(in.gcount());
+            }
+        } else {
+            Resource copy;
+            copy.file = resource.file;
+            copy.size = resource.size;
+            copy.member = resource.member;
+            _read_data(copy);
+            hash.update(copy.data.data(), copy.data.size());
+        }
+        hashes[i] = hash.hex();
+    });
+    Sha256 res;
+    for (std::size_t i = 0; i < resources.size(); ++i) {
+        auto const line = resources[i].alias + '\0' + resources[i].mode
+                + '\0' + hashes[i] + '\n';
+        res.update(line.data(), line.size());
+    }
+    return res.hex();
+}
+
+// returns the list of output files with their contents
+inline std::vector<std::pair<std::string, Content> >
+_generate(Options const& options, std::vector<Resource> const& resources)
+{
+    std::vector<std::pair<std::string, Content> > res;
+    if (options.lang == "c") {
+        res.push_back(std::make_pair(options.output,
+                                     _generate_c_header(options, resources)));
+        res.push_back(std::make_pair(_source_path(options.output, ".c"),
+                                     _generate_c_source(options, resources)));
+    } else if (options.layout == "module") {
+        res.push_back(std::make_pair(options.output,
+                                     _generate_module_interface(options,
+                                                                resources)));
+        res.push_back(std::make_pair(
+                          _source_path(options.output, ".cpp"),
+                          _generate_module_source(options, resources)));
+        if (_has_cbor(options)) {
+            res.push_back(std::make_pair(
+                              _source_path(options.output, "_cbor.hpp"),
+                              _generate_cbor_header()));
+        }
+    } else if (options.layout == "split") {
+        res.push_back(std::make_pair(options.output,
+                                     _generate_api_header(options,
+                                                          resources)));
+        res.push_back(std::make_pair(_source_path(options.output, ".cpp"),
+                                     _generate_source(options, resources)));
+        if (_has_cbor(options)) {
+            res.push_back(std::make_pair(
+                              _source_path(options.output, "_cbor.hpp"),
+                              _generate_cbor_header()));
+        }
+    } else {
+        res.push_back(std::make_pair(options.output,
+                                     _generate_header(options, resources)));
+    }
+    if (options.content_hash) {
+        auto const line = "// resources sha256 " + _content_hash(resources)
+                + "\n";
+        for (auto& pair : res) {
+            auto& content = pair.second;
+            content.text.insert(0, line);
+            for (auto& fragment : content.fragments) {
+                fragment.offset += line.size();
+            }
+        }
+    }
+    auto has_objects = std::any_of(
+                resources.begin(), resources.end(),
+                [] (Resource const& resource)
+    { return resource.mode == "object"; });
+    if (has_objects) {
+        res.push_back(std::make_pair(_source_path(options.output, "_data.o"),
+                                     _generate_object(options, resources)));
+    }
+    return res;
+}
+
+// part of a generated file at 'offset', either text, a fragment, or the
+// bytes of 'file' from 'begin'
+struct Piece
+{
+    Piece(uint64_t offset, char const* data, std::string const* file,
+          uint64_t begin, std::size_t size)
+        : offset(offset),
+          data(data),
+          file(file),
+          begin(begin),
+          size(size)
+    { }
+
+    uint64_t offset;
+    char const* data;
+    std::string const* file;
+    uint64_t begin;
+    std::size_t size;
+};
+
+// lays out the text and fragments of 'content' in file order, in pieces of
+// at most 'limit' bytes
+inline std::vector<Piece>
+_pieces(Content const& content, std::size_t limit = std::size_t(-1))
+{
+    std::vector<Piece> res;
+    uint64_t offset = 0;
+    auto const add = [&] (char const* data, std::string const* file,
+                          uint64_t begin, std::size_t size)
+    {
+        for (std::size_t pos = 0; pos < size; pos += limit) {
+            res.push_back(Piece(offset, data ? data + pos : nullptr, file,
+                                begin + pos, std::min(limit, size - pos)));
+            offset += res.back().size;
+        }
+    };
+    std::size_t text = 0;
+    for (auto const& fragment : content.fragments) {
+        add(content.text.data() + text, nullptr, 0, fragment.offset - text);
+        if (fragment.file) {
+            add(nullptr, fragment.file, fragment.begin, fragment.size);
+        } else {
+            add(fragment.data->data() + fragment.begin, nullptr, 0,
+                fragment.size);
+        }
+        text = fragment.offset;
+    }
+    add(content.text.data() + text, nullptr, 0, content.text.size() - text);
+    return res;
+}
+
+// the bytes of 'piece', read into 'buffer' if they come from a file,
+// nullptr if the file can't be read
+inline char const*
+_piece_data(Piece const& piece, char* buffer)
+{
+    if (!piece.file) {
+        return piece.data;
+    }
+    std::ifstream in(*piece.file, std::ios::binary);
+    in.seekg(std::streamoff(piece.begin));
+    if (!in.read(buffer, std::streamsize(piece.size))) {
+        std::cerr << "[FAIL] Can't read file '" << *piece.file << "'"
+                  << std::endl;
+        return nullptr;
+    }
+    return buffer;
+}
+
+inline bool
+_write_content(std::ostream& file, Content const& content)
+{
+    std::vector<char> buffer(1 << 20);
+    for (auto const& piece : _pieces(content, buffer.size())) {
+        auto const data = _piece_data(piece, buffer.data());
+        if (!data) {
+            return false;
+        }
+        file.write(data, std::streamsize(piece.size));
+    }
+    return true;
+}
+
+// compile time of a mode, in seconds: fixed + per_byte * size
+struct Cost
+{
+    Cost()
+        : fixed(),
+          per_byte()
+    { }
+
+    double fixed;
+    double per_byte;
+};
+
+inline std::string
+_default_cxx()
+{
+    auto cxx = std::getenv("CXX");
+    return cxx && *cxx ? cxx : "c++";
+}
+
+inline std::string
+_default_cc()
+{
+    auto cc = std::getenv("CC");
+    return cc && *cc ? cc : "cc";
+}
+
+// compiler the output is built with, the one 'auto' mode times
+inline std::string const&
+_compiler(Options const& options)
+{
+    return options.lang == "c" ? options.cc : options.cxx;
+}
+
+// candidates for 'auto' mode, from the most to the least preferred on ties;
+// 'object' is left out as it needs an extra file in the link
+char const* const auto_modes[] = { "array", "words", "string", "embed",
+                                   "incbin" };
+
+// path of the costs of the compiler of 'options' in --cache-dir, named by
+// its command and the version it reports; empty without --cache-dir
+inline std::string
+_costs_path(Options const& options)
+{
+    if (options.cache_dir.empty()) {
+        return std::string();
+    }
+    auto const command = _compiler(options);
+    std::vector<char> version;
+    _run_filter(command + " --version", std::vector<char>(), version);
+    auto const key = options.lang + "\n" + command + "\n"
+            + std::string(version.begin(), version.end());
+    return options.cache_dir + "/costs-" + Sha256().update(key.data(),
+                                                           key.size())
+            .hex() + "-" + cache_format;
+}
+
+// reads the costs stored by _store_costs, false if there are none
+inline bool
+_load_costs(std::string const& path, std::map<std::string, Cost>& costs)
+{
+    std::string text;
+    if (path.empty() || !_load_cached(path, text)) {
+        return false;
+    }
+    std::istringstream in(text);
+    std::string mode;
+    Cost cost;
+    while (in >> mode >> cost.fixed >> cost.per_byte) {
+        costs[mode] = cost;
+    }
+    return true;
+}
+
+// keeps the costs of the supported modes, a line 'mode fixed per_byte' each
+inline void
+_store_costs(std::string const& path,
+             std::map<std::string, Cost> const& costs)
+{
+    if (path.empty()) {
+        return;
+    }
+    std::ostringstream out;
+    out.precision(17);
+    for (auto const& pair : costs) {
+        out << pair.first << " " << pair.second.fixed << " "
+            << pair.second.per_byte << "\n";
+    }
+    // the entry of a compiler that supports no mode isn't empty
+    out << "\n";
+    auto const text = out.str();
+    _store_cached(path, text.data(), text.size());
+}
+
+// compiles a sample resource in every candidate mode at two sizes with the
+// given compiler (GCC/Clang-style command line) and fits a linear cost; the
+// costs are kept in --cache-dir for the same compiler command and version
+inline std::map<std::string, Cost>
+_probe_compiler(Options const& options)
+{
+    std::map<std::string, Cost> res;
+    auto const path = _costs_path(options);
+    if (_load_costs(path, res)) {
+        std::cout << "[INFO] Costs of the modes for '" << _compiler(options)
+                  << "' are read from '" << path << "'" << std::endl;
+        return res;
+    }
+    auto const stem = _temp_directory() + "/cpp-generes-probe-"
+            + std::to_string(std::chrono::steady_clock::now()
+                             .time_since_epoch().count());
+    std::size_t const sizes[] = { std::size_t(1) << 16, std::size_t(1) << 20 };
+    std::vector<char> sample(sizes[1]);
+    uint32_t seed = 1;
+    for (auto& c : sample) {
+        seed = seed * 1664525u + 1013904223u;
+        c = static_cast<char>(seed >> 24);
+    }
+#if defined(_WIN32)
+    auto const quiet = " > NUL 2>&1";
+#else
+    auto const quiet = " > /dev/null 2>&1";
+#endif  // _WIN32
+    std::vector<std::string> temporaries;
+    for (auto mode : auto_modes) {
+        double seconds[2] = { 0, 0 };
+        bool is_supported = true;
+        for (std::size_t k = 0; k < 2 && is_supported; ++k) {
+            Resource resource;
+            resource.file = stem + "-" + std::to_string(k) + ".bin";
+            resource.alias = "probe";
+            resource.data.assign(sample.begin(),
+                                 sample.begin() + std::ptrdiff_t(sizes[k]));
+            resource.size = resource.data.size();
+            resource.mode = mode;
+            resource.encoded = _encode(resource);
+            std::ofstream(resource.file, std::ios::binary)
+                    .write(resource.data.data(),
+                           std::streamsize(resource.data.size()));
+            Options probe = options;
+            probe.output = stem + (options.lang == "c" ? ".h" : ".hpp");
+            probe.layout = "split";
+            // the compiler runs here, not in the directory of the output
+            probe.relative_to = ".";
+            // the generated content refers to the data of the resources
+            std::vector<Resource> const resources = { resource };
+            auto const files = _generate(probe, resources);
+            for (auto const& pair : files) {
+                std::ofstream out(pair.first, std::ios::binary);
+                _write_content(out, pair.second);
+                temporaries.push_back(pair.first);
+            }
+            temporaries.push_back(resource.file);
+            temporaries.push_back(stem + ".o");
+            auto const command = _compiler(options) + " -c \""
+                    + files[1].first
+                    + "\" -o \"" + stem + ".o\"" + quiet;
+            auto const start = std::chrono::steady_clock::now();
+            is_supported = std::system(command.c_str()) == 0;
+            seconds[k] = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+        }
+        if (!is_supported) {
+            std::cout << "[INFO] Mode '" << mode << "' is not supported by '"
+                      << _compiler(options) << "'" << std::endl;
+            continue;
+        }
+        Cost cost;
+        cost.per_byte = std::max(0.0, (seconds[1] - seconds[0])
+                                 / double(sizes[1] - sizes[0]));
+        cost.fixed = std::max(0.0, seconds[0] - cost.per_byte
+                              * double(sizes[0]));
+        res[mode] = cost;
+        std::cout << "[ OK ] Mode '" << mode << "' compiles in "
+                  << cost.fixed << " s + " << cost.per_byte * (1 << 20)
+                  << " s/MiB" << std::endl;
+    }
+    for (auto const& temporary : temporaries) {
+        std::remove(temporary.c_str());
+    }
+    _store_costs(path, res);
+    return res;
+}
+
+// whether 'path' can be written between the quotes of #embed, where escape
+// sequences aren't processed and some characters are implementation-defined
+inline bool
+_is_header_name(std::string const& path)
+{
+    return std::none_of(path.begin(), path.end(), [] (char c)
+    {
+        return c == '"' || c == '\\' || c == '\'' || c == '?'
+                || std::iscntrl(static_cast<unsigned char>(c));
+    }) && path.find("//") == std::string::npos
+            && path.find("/*") == std::string::npos;
+}
+
+// data goes through the compiler front end in these modes
+inline bool
+_is_compiled(std::string const& mode)
+{
+    return mode == "array" || mode == "string" || mode == "raw"
+            || mode == "raw-utf8" || mode == "words" || mode == "embed";
+}
+
+// data is encoded into the initializers of the generated code in these modes
+inline bool
+_is_encoded(std::string const& mode)
+{
+    return mode == "array" || mode == "string" || mode == "raw"
+            || mode == "raw-utf8" || mode == "words";
+}
+
+// sets the emission mode of every resource and encodes those that need it
+inline void
+_resolve_modes(Options const& options,
+               std::map<std::string, Cost> const& costs,
+               std::vector<Resource>& resources, FileCache* cache = nullptr)
+{
+    std::vector<Resource*> unread;
+    for (auto& resource : resources) {
+        auto mode = resource.preferred.empty() ? options.mode
+                                               : resource.preferred;
+        if (mode == "auto") {
+            mode.clear();
+            double best = 0;
+            for (auto candidate : auto_modes) {
+                auto it = costs.find(candidate);
+                if (it == costs.end() || (_is_compiled(candidate)
+                                          && resource.size >= large_size)) {
+                    continue;
+                }
+                auto cost = it->second.fixed
+                        + it->second.per_byte * double(resource.size);
+                if (mode.empty() || cost < best) {
+                    mode = candidate;
+                    best = cost;
+                }
+            }
+            if (mode.empty()) {
+                mode = resource.size >= large_size ? "object" : "array";
+            }
+        }
+        // typed data is written as literals of its elements
+        if ((resource.size == 0 && (mode == "embed" || mode == "incbin"))
+                || !resource.type.empty()) {
+            mode = "array";
+        }
+        // C has no raw string literals
+        if ((mode == "raw" || mode == "raw-utf8") && options.lang == "c") {
+            mode = "string";
+        }
+        // #embed can't take a part of a file or a path that isn't a valid
+        // header name, and neither can reference data that is only in memory
+        auto const& member = resource.member;
+        auto const is_in_memory = _is_in_memory(resource);
+        if ((mode == "embed" && (!member.name.empty() || is_in_memory
+                                 || !_is_header_name(
+                                     _emitted_path(options, resource, true))))
+                || (mode == "incbin" && is_in_memory)) {
+            mode = resource.size >= large_size ? "object" : "array";
+        }
+        if (resource.mode != mode) {
+            resource.mode = mode;
+            resource.encoded.clear();
+        }
+        // too large data is rejected by _check_limits, don't even read it
+        if (_is_encoded(mode) ? resource.encoded.empty()
+                                && resource.size < large_size
+                              : mode == "object" && is_in_memory
+                                && resource.data.size() != resource.size) {
+            unread.push_back(&resource);
+        }
+    }
+    // filtered and typed data is already in memory, the cache has the file
+    // contents
+    auto const is_cached = [cache] (Resource const* resource)
+    {
+        return cache && _is_encoded(resource->mode)
+                && resource->filter.empty() && resource->type.empty();
+    };
+    // unchanged files have their fragments in --cache-dir and aren't read
+    std::vector<Resource*> uncached;
+    std::vector<Resource*> unencoded;
+    for (auto resource : unread) {
+        if (is_cached(resource)) {
+            unencoded.push_back(resource);
+        } else if (!_is_encoded(resource->mode)
+                   || !_load_encoded(*resource, options.cache_dir)) {
+            uncached.push_back(resource);
+            unencoded.push_back(resource);
+        }
+    }
+    _read_files(uncached);
+    // in manifest runs the bundles are already generated in parallel
+    _parallel_for(unencoded.size(), cache ? 1 : _hardware_threads(),
+                  [&] (std::size_t i)
+    {
+        auto resource = unencoded[i];
+        auto is_read = is_cached(resource)
+                ? cache->encode(*resource, options.cache_dir)
+                : resource->data.size() == resource->size;
+        if (!is_read) {
+            resource->size = 0;
+        }
+        if (!is_read || !is_cached(resource)) {
+            resource->encoded = _encode(*resource, options.cache_dir);
+        }
+    });
+}
+
+// fails on data compilers can't take and explains how to use large data
+// and where the assembler finds the files of 'incbin' resources
+inline bool
+_check_limits(Options const& options, std::vector<Resource> const& resources)
+{
+    bool res = true;
+    auto const has_incbin = std::any_of(
+                resources.begin(), resources.end(),
+                [] (Resource const& resource)
+    { return resource.mode == "incbin"; });
+    if (has_incbin && options.relative_to.empty() && options.output != "-") {
+        auto dir = _directory_name(options.output);
+        dir = dir.empty() ? "." : dir;
+        std::cout << "[INFO] The files of 'incbin' resources are relative to "
+                  << "'" << dir << "', compile with -Wa,-I" << dir
+                  << " or give --relative-to" << std::endl;
+    }
+    for (auto const& resource : resources) {
+        if (resource.size < large_size) {
+            continue;
+        }
+        if (_is_compiled(resource.mode)) {
+            std::cerr << "[FAIL] Resource '" << resource.alias << "' has "
+                      << resource.size << " bytes, compilers can't handle "
+                      << "2 GiB and more in '" << resource.mode << "' mode, "
+                      << "use --mode incbin, object or auto" << std::endl;
+            res = false;
+        } else {
+            std::cout << "[INFO] Resource '" << resource.alias << "' has "
+                      << resource.size << " bytes and is placed in a large "
+                      << "data section on x86-64, compile code that uses it "
+                      << "with -mcmodel=medium (-mcmodel=large elsewhere)"
+                      << std::endl;
+        }
+    }
+    return res;
+}
+
+// outputs of at least this size are compared and written through memory
+// mappings, with the pieces copied by several threads
+uint64_t constexpr mapped_size = uint64_t(1) << 24;
+
+inline bool
+_is_same_content(std::string const& output, Content const& content)
+{
+    auto const size = content.size();
+#if defined(__linux__)
+    if (size >= mapped_size) {
+        int fd = ::open(output.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        std::atomic<bool> res(false);
+        struct stat info;
+        if (::fstat(fd, &info) == 0 && uint64_t(info.st_size) == size) {
+            auto map = ::mmap(nullptr, static_cast<std::size_t>(size),
+                              PROT_READ, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) {
+                auto const pieces = _pieces(content, 1 << 20);
+                res = true;
+                _parallel_for(pieces.size(), _hardware_threads(),
+                              [&] (std::size_t i)
+                {
+                    auto const& piece = pieces[i];
+                    std::vector<char> buffer(piece.file ? piece.size : 0);
+                    auto const data = res ? _piece_data(piece, buffer.data())
+                                          : nullptr;
+                    if (!data || std::memcmp(static_cast<char const*>(map)
+                                             + piece.offset,
+                                             data, piece.size) != 0) {
+                        res = false;
+                    }
+                });
+                ::munmap(map, static_cast<std::size_t>(size));
+            }
+        }
+        ::close(fd);
+        return res;
+    }
+#endif  // __linux__
+    std::ifstream in(output, std::ios::binary | std::ios::ate);
+    if (!in.is_open() || static_cast<uint64_t>(in.tellg()) != size) {
+        return false;
+    }
+    in.seekg(0);
+    std::vector<char> buffer(1 << 20);
+    std::vector<char> input(buffer.size());
+    for (auto const& piece : _pieces(content, buffer.size())) {
+        auto const data = _piece_data(piece, input.data());
+        if (!data || !in.read(buffer.data(), std::streamsize(piece.size))
+                || std::memcmp(buffer.data(), data, piece.size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool
+_write_temporary(std::string const& output, Content const& content)
+{
+    auto const size = content.size();
+#if defined(__linux__)
+    if (size >= mapped_size) {
+        int fd = ::open(output.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+                        0666);
+        if (fd < 0) {
+            return false;
+        }
+        // reserve the blocks first, running out of space while writing to
+        // the mapping would raise SIGBUS
+        bool res = ::ftruncate(fd, off_t(size)) == 0;
+        auto error = res ? ::posix_fallocate(fd, 0, off_t(size)) : 0;
+        res = res && (error == 0 || error == EINVAL || error == EOPNOTSUPP);
+        auto map = res ? ::mmap(nullptr, static_cast<std::size_t>(size),
+                                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                       : MAP_FAILED;
+        if (map != MAP_FAILED) {
+            auto const pieces = _pieces(content, 1 << 20);
+            std::atomic<bool> copied(true);
+            _parallel_for(pieces.size(), _hardware_threads(),
+                          [&] (std::size_t i)
+            {
+                // files are read straight into the mapping
+                auto const target = static_cast<char*>(map) + pieces[i].offset;
+                auto const data = _piece_data(pieces[i], target);
+                if (!data) {
+                    copied = false;
+                } else if (data != target) {
+                    std::memcpy(target, data, pieces[i].size);
+                }
+            });
+            res = ::munmap(map, static_cast<std::size_t>(size)) == 0
+                    && copied;
+        } else {
+            res = false;
+        }
+        return ::close(fd) == 0 && res;
+    }
+#endif  // __linux__
+    std::ofstream file(output, std::ios::binary);
+    auto const res = _write_content(file, content);
+    file.flush();
+    return res && !!file;
+}
+// writes a temporary file next to 'output' that is then renamed over it,
+// so that a failure never leaves 'output' partially written
+inline bool
+_write_file(std::string const& output, Content const& content)
+{
+    auto const temporary = output + ".tmp"
+            + std::to_string(std::random_device()());
+    if (!_write_temporary(temporary, content)) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    std::remove(output.c_str());
+#endif  // _WIN32
+    if (std::rename(temporary.c_str(), output.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+inline bool
+_write_output(std::string const& output, Content const& content)
+{
+    if (output == "-") {
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif  // _WIN32
+        std::vector<char> buffer(1 << 20);
+        auto read = true;
+        for (auto const& piece : _pieces(content, buffer.size())) {
+            auto const data = _piece_data(piece, buffer.data());
+            if (!data) {
+                read = false;
+                break;
+            }
+            std::fwrite(data, 1, piece.size, stdout);
+        }
+        if (!read || std::fflush(stdout) != 0 || std::ferror(stdout)) {
+            std::cerr << "[FAIL] Can't write to the standard output"
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
+    auto dir = _directory_name(output);
+    if (!dir.empty() && dir != "." && !_is_directory_exists(dir)) {
+        if (!_make_directory(dir)) {
+            std::cerr << "[FAIL] Can't create directory '" << dir
+                      << "' for output file '" << output << "'" << std::endl;
+            return false;
+        }
+    }
+    // keep the file untouched if nothing changed, so it isn't rebuilt
+    if (_is_same_content(output, content)) {
+        std::cout << "[ OK ] File '" << output << "' is up to date"
+                  << std::endl;
+        return true;
+    }
+    if (!_write_file(output, content)) {
+        std::cerr << "[FAIL] Can't write output file '" << output << "'"
+                  << std::endl;
+        return false;
+    }
+
+    std::cout << "[ OK ] File '" << output << "' generated" << std::endl;
+    return true;
+}
+
+inline bool
+_write_outputs(std::vector<std::pair<std::string, Content> > const& files)
+{
+    if (files.size() > 1 && files.front().first == "-") {
+        std::cerr << "[FAIL] Only a single header can be written to the "
+                  << "standard output, use --layout header and --lang c++ "
+                  << "without 'object' mode" << std::endl;
+        return false;
+    }
+    bool res = true;
+    for (auto const& pair : files) {
+        res = _write_output(pair.first, pair.second) && res;
+    }
+    return res;
+}
+
+// true if resource modes have to be picked by timing the compiler
+inline bool
+_needs_probe(Options const& options)
+{
+    return options.mode == "auto"
+            || std::any_of(options.inputs.begin(), options.inputs.end(),
+                           [] (Input const& input)
+    { return input.mode == "auto"; });
+}
+
+// fixes the output extension for the language and layout and sets the
+// include guard macro
+inline void
+_normalize(Options& options)
+{
+    if (options.output == "-") {
+        // the standard output, the guard is derived from the name instead
+    } else if (options.lang == "c") {
+        if (_ends_with(options.output, ".hpp")) {
+            options.output = _source_path(options.output, ".h");
+        } else if (!_ends_with(options.output, ".h")) {
+            options.output += ".h";
+        }
+    } else if (options.layout == "module") {
+        if (_ends_with(options.output, ".h")
+                || _ends_with(options.output, ".hpp")) {
+            options.output = _source_path(options.output, ".cppm");
+        } else if (!_ends_with(options.output, ".cppm")
+                   && !_ends_with(options.output, ".ixx")) {
+            options.output += ".cppm";
+        }
+    } else if (!_ends_with(options.output, ".h")
+               && !_ends_with(options.output, ".hpp")) {
+        options.output += ".hpp";
+    }
+
+    auto define = _file_name(options.output);
+    if (options.output == "-") {
+        define = options.name + (options.lang == "c" ? ".h" : ".hpp");
+    }
+    define = _replace(define, [] (unsigned char c)
+    { return std::iscntrl(c); }, "");
+    define = _replace(define, [] (unsigned char c)
+    { return std::ispunct(c); }, "_");
+    define = _replace(define, ' ', "_");
+    options.define = "_" + _to_upper(options.name_space)
+            + "_" + _to_upper(define) + "_";
+}
+
+inline std::string
+_trim(std::string const& str)
+{
+    auto const spaces = " \t\r";
+    auto begin = str.find_first_not_of(spaces);
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    return str.substr(begin, str.find_last_not_of(spaces) + 1 - begin);
+}
+
+// reads an INI manifest, every [section] describes one bundle:
+//
+//   mode = auto                    ; before any section: for all bundles
+//   [ui]
+//   output = gen/ui.hpp            ; default: <section>.hpp
+//   name = ui                      ; default: <section>
+//   namespace = app
+//   resource = icons/logo.png:logo
+//   resource = shaders/main.frag:main.frag:string
+//
+// keys are the long command line options (guards, name, namespace, output,
+// layout, lang, mode, cxx, cc, object-arch, chunk-size) plus 'resource',
+// which can be repeated; the command line gives the defaults and relative
+// paths are taken from the manifest directory
+inline bool
+_read_manifest(Options const& defaults, std::vector<Options>& bundles)
+{
+    std::ifstream in(defaults.manifest);
+    if (!in.is_open()) {
+        std::cerr << "[FAIL] Can't open manifest '" << defaults.manifest
+                  << "'" << std::endl;
+        return false;
+    }
+    auto const dir = _directory_name(defaults.manifest);
+    auto const resolve = [&dir] (std::string const& path)
+    {
+        auto is_absolute = (!path.empty()
+                            && (path[0] == '/' || path[0] == '\\'))
+                || (path.size() > 1 && path[1] == ':');
+        return dir.empty() || is_absolute || path == "-" ? path
+                                                       : dir + "/" + path;
+    };
+    std::map<std::string, std::vector<std::string> > const choices = {
+        { "guards", { "define", "pragma" } },
+        { "layout", { "header", "split", "module" } },
+        { "lang", { "c++", "c" } },
+        { "mode", { "array", "string", "raw", "raw-utf8", "words", "embed",
+                    "incbin", "object", "auto" } },
+        { "object-arch", { "x86_64", "aarch64", "riscv64", "ppc64le" } },
+    };
+
+    Options common = defaults;
+    common.inputs.clear();
+    std::vector<std::string> sections;
+    std::size_t number = 0;
+    bool res = true;
+    auto const fail = [&] (std::string const& message)
+    {
+        std::cerr << "[FAIL] " << defaults.manifest << ":" << number << ": "
+                  << message << std::endl;
+        res = false;
+    };
+    for (std::string line; std::getline(in, line); ) {
+        ++number;
+        line = _trim(line.substr(0, line.find_first_of(";#")));
+        if (line.empty()) {
+            continue;
+        }
+        if (line.front() == '[') {
+            auto section = _trim(line.substr(1, line.find(']') - 1));
+            if (line.back() != ']' || section.empty()) {
+                fail("malformed section '" + line + "'");
+                continue;
+            }
+            if (std::find(sections.begin(), sections.end(), section)
+                    != sections.end()) {
+                fail("duplicate section '" + section + "'");
+            }
+            sections.push_back(section);
+            bundles.push_back(common);
+            bundles.back().name.clear();
+            bundles.back().output.clear();
+            continue;
+        }
+        auto pos = line.find('=');
+        if (pos == std::string::npos) {
+            fail("expected 'key = value', got '" + line + "'");
+            continue;
+        }
+        auto const key = _trim(line.substr(0, pos));
+        auto const value = _trim(line.substr(pos + 1));
+        auto& options = bundles.empty() ? common : bundles.back();
+        auto it = choices.find(key);
+        if (it != choices.end() && std::find(it->second.begin(),
+                                             it->second.end(), value)
+                == it->second.end()) {
+            fail("invalid value '" + value + "' for '" + key + "'");
+        } else if (key == "resource") {
+            Input input;
+            if (_parse_input(value, input)) {
+                input.file = resolve(input.file);
+                options.inputs.push_back(input);
+            } else {
+                res = false;
+            }
+        } else if ((key == "name" || key == "output") && bundles.empty()) {
+            fail("'" + key + "' has to be given per section");
+        } else if (key == "name") {
+            options.name = value;
+        } else if (key == "output" && value == "-") {
+            fail("bundles can't be written to the standard output");
+        } else if (key == "output") {
+            options.output = resolve(value);
+        } else if (key == "namespace") {
+            options.name_space = value;
+        } else if (key == "guards") {
+            options.guards = value;
+        } else if (key == "layout") {
+            options.layout = value;
+        } else if (key == "lang") {
+            options.lang = value;
+        } else if (key == "mode") {
+            options.mode = value;
+        } else if (key == "object-arch") {
+            options.arch = value;
+        } else if (key == "cxx") {
+            options.cxx = value;
+        } else if (key == "cc") {
+            options.cc = value;
+        } else if (key == "filter") {
+            if (!_parse_filter(value, options)) {
+                res = false;
+            }
+        } else if (key == "fingerprint") {
+            options.fingerprints.push_back(value);
+        } else if (key == "chunk-size") {
+            char* end = nullptr;
+            auto size = std::strtoull(value.c_str(), &end, 10);
+            if (value.empty() || *end != '\0') {
+                fail("invalid value '" + value + "' for '" + key + "'");
+            }
+            options.chunk_size = static_cast<std::size_t>(size);
+        } else {
+            fail("unknown key '" + key + "'");
+        }
+    }
+    if (bundles.empty()) {
+        std::cerr << "[FAIL] Manifest '" << defaults.manifest
+                  << "' has no bundles" << std::endl;
+        return false;
+    }
+    std::set<std::string> outputs;
+    for (std::size_t i = 0; i < bundles.size(); ++i) {
+        auto& options = bundles[i];
+        if (options.name.empty()) {
+            options.name = _identifier(sections[i]);
+        }
+        if (options.output.empty()) {
+            options.output = resolve(sections[i] + ".hpp");
+        }
+        _normalize(options);
+        res = _expand_inputs(options.inputs) && res;
+        if (!outputs.insert(_absolute_path(options.output)).second) {
+            std::cerr << "[FAIL] Bundle '" << sections[i] << "' writes to '"
+                      << options.output << "' as well" << std::endl;
+            res = false;
+        }
+    }
+    return res;
+}
+
+// generates all bundles on a pool of threads, files used by several of
+// them are read and encoded once
+inline bool
+_generate_bundles(std::vector<Options> const& bundles)
+{
+    // probe every compiler before the bundles compete for the processors
+    std::map<std::string, std::map<std::string, Cost> > costs;
+    for (auto const& options : bundles) {
+        auto const key = options.lang + " " + _compiler(options);
+        if (_needs_probe(options) && costs.count(key) == 0) {
+            costs[key] = _probe_compiler(options);
+        }
+    }
+    std::map<std::string, Cost> const none;
+    FileCache cache;
+    std::atomic<bool> res(true);
+    _parallel_for(bundles.size(), _hardware_threads(), [&] (std::size_t i)
+    {
+        auto const& options = bundles[i];
+        auto resources = _load_resources(options.inputs);
+        if (!_apply_filters(options, resources, &cache)
+                || !_convert_elements(resources)
+                || !_add_variants(options, resources, &cache)
+                || !_add_fingerprints(options, resources)) {
+            res = false;
+            return;
+        }
+        auto it = costs.find(options.lang + " " + _compiler(options));
+        _resolve_modes(options, it != costs.end() ? it->second : none,
+                       resources, &cache);
+        if (!_check_limits(options, resources)
+                || !_write_outputs(_generate(options, resources))) {
+            res = false;
+        }
+    });
+    return res;
+}
+}  // namespace detail
+
+int main(int argc, char const* argv[])
+{
+    auto const default_namespace = "resources";
+    auto const default_name = "resources";
+    auto const default_output = "resources.hpp";
+
+    auto parser = argparse::ArgumentParser(argc, argv)
+            .description("Tool to generate C++ files with binary resources")
+            .epilog("by rue-ryuzaki (c) 2022-2023")
+            .fromfile_prefix_chars("@")
+            .formatter_class(argparse::ArgumentDefaultsHelpFormatter);
+    parser.add_argument("--version")
+            .action("version")
+            .version(version);
+    parser.add_argument("resources")
+            .action("extend")
+            .nargs("*")
+            .metavar("file:alias")
+            .type<std::string>()
+            .help("list of resources, an alias can be followed by ':' and a "
+                  "mode to override --mode for that resource, and by an "
+                  "element type like ':f32le' (i8-i64, u8-u64, f32, f64 with "
+                  "'le' or 'be' byte order) for typed data read in place, "
+                  "taken from numbers in .csv, .tsv and .txt files, or "
+                  "':utf16' and ':utf32' for UTF-8 text transcoded to "
+                  "terminated char16_t and char32_t arrays; a "
+                  "directory or "
+                  "a pattern like 'assets/**/*.png' adds every file it "
+                  "matches, with the alias as a prefix for its relative "
+                  "path; so does a .tar or .zip archive if the alias is "
+                  "empty or ends with '/'; '-' reads the standard input, "
+                  "given after '--' as in '-- -:alias'");
+    parser.add_argument("--guards")
+            .type<std::string>()
+            .choices({ "define", "pragma" })
+            .default_value("define")
+            .help("include guards");
+    parser.add_argument("--name")
+            .default_value(default_name)
+            .help("name for resources");
+    parser.add_argument("--namespace")
+            .type<std::string>()
+            .default_value(default_namespace)
+            .help("namespace for resources");
+    parser.add_argument("-o", "--output")
+            .metavar("file")
+            .type<std::string>()
+            .default_value(default_output)
+            .help("output file name, '-' writes a single header to the "
+                  "standard output");
+    parser.add_argument("--layout")
+            .type<std::string>()
+            .choices({ "header", "split", "module" })
+            .default_value("header")
+            .help("'header' embeds everything into the output file, 'split' "
+                  "writes a light header with declarations only and a source "
+                  "file with the data next to it, 'module' writes a C++20 "
+                  "module interface unit named after --name and an "
+                  "implementation unit with the data");
+    parser.add_argument("--lang")
+            .type<std::string>()
+            .choices({ "c++", "c" })
+            .default_value("c++")
+            .help("output language, 'c' writes a .h/.c pair with plain "
+                  "arrays and a lookup function (--layout is ignored)");
+    parser.add_argument("--mode")
+            .type<std::string>()
+            .choices({ "array", "string", "raw", "raw-utf8", "words", "embed",
+                       "incbin", "object", "auto" })
+            .default_value("array")
+            .help("'array' embeds resources as byte initializers, 'string' "
+                  "as string literals, 'raw' ASCII text as raw string "
+                  "literals (as 'string' for other data and in C), "
+                  "'raw-utf8' UTF-8 text too, for compilers that read the "
+                  "sources as UTF-8 (MSVC needs /utf-8), all three with a "
+                  "NUL past the size, 'words' as 64-bit word initializers, "
+                  "'embed' with #embed, 'incbin' with the assembler .incbin "
+                  "directive, 'object' writes them into an ELF object file "
+                  "next to the output (<output>_data.o) that has to be "
+                  "linked in, 'auto' times the compiler given by --cxx (--cc "
+                  "for C) and picks the fastest of 'array', 'words', "
+                  "'string', 'embed' and 'incbin' per resource");
+    parser.add_argument("--cxx")
+            .metavar("command")
+            .type<std::string>()
+            .default_value(detail::_default_cxx())
+            .help("compiler command (with flags) used to probe 'auto' mode");
+    parser.add_argument("--cc")
+            .metavar("command")
+            .type<std::string>()
+            .default_value(detail::_default_cc())
+            .help("C compiler command (with flags) used to probe 'auto' "
+                  "mode with --lang c");
+    parser.add_argument("--object-arch")
+            .type<std::string>()
+            .choices({ "x86_64", "aarch64", "riscv64", "ppc64le" })
+            .default_value(detail::_host_arch())
+            .help("target architecture of the object file in 'object' mode");
+    parser.add_argument("--chunk-size")
+            .metavar("bytes")
+            .type<std::size_t>()
+            .default_value("0")
+            .help("in 'array' mode, split resources larger than this into "
+                  "contiguous sub-arrays of this size (e.g. 65536) so that "
+                  "compile time grows linearly, 0 disables splitting");
+    parser.add_argument("--manifest")
+            .metavar("file")
+            .type<std::string>()
+            .default_value("")
+            .help("INI file describing several bundles, one per [section], "
+                  "that are all generated in parallel; the other options "
+                  "give the defaults for them");
+    parser.add_argument("--cache-dir")
+            .metavar("directory")
+            .type<std::string>()
+            .default_value("")
+            .help("content-addressed store of encoded resources, keyed on "
+                  "the SHA-256 of their data, mode and type, that can be "
+                  "shared by runs, concurrent generators, checkouts and "
+                  "machines: the same data is then read from it instead "
+                  "of being encoded again, and a local index spares reading "
+                  "unchanged files; it also keeps the costs that --mode auto "
+                  "measures for each compiler");
+    parser.add_argument("--filter")
+            .action("append")
+            .metavar("ext=command")
+            .type<std::string>()
+            .help("pipe files with this extension through a shell command "
+                  "(e.g. 'js=terser -c'), or a built-in filter by its name "
+                  "('lf' converts CRLF line endings, 'json', 'css', 'html' "
+                  "and 'glsl' minify, 'cbor' converts JSON to CBOR read "
+                  "through cpp_generes::cbor, 'gzip' compresses); filtered "
+                  "resources are held in memory and not served in "
+                  "development mode");
+    parser.add_argument("--minify")
+            .action("store_true")
+            .help("minify .json, .css, .html/.htm and GLSL (.glsl, .vert, "
+                  ".frag, .geom, .comp, .tesc, .tese) resources that have "
+                  "no --filter with the built-in filters");
+    parser.add_argument("--relative-to")
+            .metavar("directory")
+            .type<std::string>()
+            .default_value("")
+            .help("write the paths of 'incbin' resources and of development "
+                  "mode relative to this directory, the one the compiler and "
+                  "the program run in, instead of relative to the output "
+                  "(that needs -Wa,-I<output directory> for 'incbin')");
+    parser.add_argument("--content-hash")
+            .action("store_true")
+            .help("start the output files with a comment holding a SHA-256 "
+                  "hash of the aliases, modes and contents of the resources, "
+                  "for compiler caches keyed on the file");
+    parser.add_argument("--precompress")
+            .metavar("codings")
+            .type<std::string>()
+            .default_value("")
+            .help("add encodings of the resources in these comma separated "
+                  "content codings ('gzip', and 'br' that needs the brotli "
+                  "command, e.g. 'gzip,br') as '<alias>.gz' and "
+                  "'<alias>.br' where they are smaller, served with ETags "
+                  "and integrity hashes by <name>_get_encoded according to "
+                  "an Accept-Encoding header");
+    parser.add_argument("--zero-copy")
+            .action("store_true")
+            .help("add <name>_get_iovec, that gives segments of the embedded "
+                  "data for writev, sendmsg or io_uring, and <name>_get_file, "
+                  "that gives the descriptor and offset of the file they "
+                  "were loaded from (the program or library on Linux, the "
+                  "original file in development mode) for sendfile or "
+                  "splice");
+    parser.add_argument("--fingerprint")
+            .action("append")
+            .metavar("pattern")
+            .type<std::string>()
+            .help("also name the resources with aliases matching this "
+                  "pattern (e.g. '**/*.js') after a hash of their contents, "
+                  "as in 'js/app.3f2a9c1d.js', translated both ways at "
+                  "compile time by <name>_fingerprinted and <name>_logical");
+    parser.add_argument("--watch")
+            .action("store_true")
+            .help("keep running and regenerate the output file whenever "
+                  "resources or response files change");
+
+    // sets 'res' from the command line, false if it has invalid resources,
+    // filters or codings, leaving 'res' as it was
+    auto const configure = [&] (detail::Options& res)
+    {
+        auto const args = parser.parse_args();
+
+        detail::Options options;
+        options.guards = args.get<std::string>("guards");
+        options.layout = args.get<std::string>("layout");
+        options.lang = args.get<std::string>("lang");
+        options.mode = args.get<std::string>("mode");
+        options.arch = args.get<std::string>("object_arch");
+        options.chunk_size = args.get<std::size_t>("chunk_size");
+        options.cxx = args.get<std::string>("cxx");
+        options.cc = args.get<std::string>("cc");
+        options.name = args.get<std::string>("name");
+        if (options.name.empty()) {
+            options.name = default_name;
+        }
+        options.output = args.get<std::string>("output");
+        if (options.output.empty()) {
+            options.output = default_output;
+        }
+        options.name_space = args.get<std::string>("namespace");
+        if (options.name_space.empty()) {
+            options.name_space = default_namespace;
+        }
+        for (auto const& spec
+             : args.get<std::vector<std::string> >("resources")) {
+            detail::Input input;
+            if (!detail::_parse_input(spec, input)) {
+                return false;
+            }
+            options.inputs.push_back(input);
+        }
+        options.given = options.inputs;
+        if (!detail::_expand_inputs(options.inputs)) {
+            return false;
+        }
+        options.manifest = args.get<std::string>("manifest");
+        for (auto const& spec
+             : args.get<std::vector<std::string> >("filter")) {
+            if (!detail::_parse_filter(spec, options)) {
+                return false;
+            }
+        }
+        if (args.get<bool>("minify")) {
+            detail::_add_minifiers(options);
+        }
+        options.cache_dir = args.get<std::string>("cache_dir");
+        options.relative_to = args.get<std::string>("relative_to");
+        options.content_hash = args.get<bool>("content_hash");
+        if (!detail::_parse_precompress(
+                    args.get<std::string>("precompress"), options)) {
+            return false;
+        }
+        options.zero_copy = args.get<bool>("zero_copy");
+        options.fingerprints
+                = args.get<std::vector<std::string> >("fingerprint");
+        options.watch = args.get<bool>("watch");
+        detail::_normalize(options);
+        res = std::move(options);
+        return true;
+    };
+
+    detail::Options options;
+    if (!configure(options)) {
+        return 1;
+    }
+    if (options.output == "-") {
+        // the standard output carries the code, so the status goes elsewhere
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
+    if (!options.cache_dir.empty()
+            && !detail::_is_directory_exists(options.cache_dir)
+            && !detail::_make_directory(options.cache_dir)) {
+        std::cerr << "[FAIL] Can't create cache directory '"
+                  << options.cache_dir << "'" << std::endl;
+        return 1;
+    }
+    if (!options.manifest.empty()) {
+        if (options.watch) {
+            std::cerr << "[FAIL] --watch can't be used with --manifest"
+                      << std::endl;
+            return 1;
+        }
+        if (!options.inputs.empty()) {
+            std::cout << "[WARN] Resources given with --manifest are ignored"
+                      << std::endl;
+        }
+        std::vector<detail::Options> bundles;
+        if (!detail::_read_manifest(options, bundles)
+                || !detail::_generate_bundles(bundles)) {
+            return 1;
+        }
+        return 0;
+    }
+    std::map<std::string, detail::Cost> costs;
+    if (detail::_needs_probe(options)) {
+        costs = detail::_probe_compiler(options);
+    }
+    auto resources = detail::_load_resources(options.inputs);
+    if (!detail::_apply_filters(options, resources)
+            || !detail::_convert_elements(resources)
+            || !detail::_add_variants(options, resources)
+            || !detail::_add_fingerprints(options, resources)) {
+        return 1;
+    }
+    detail::_resolve_modes(options, costs, resources);
+    if (!detail::_check_limits(options, resources)
+            || !detail::_write_outputs(detail::_generate(options, resources))) {
+        return 1;
+    }
+    if (!options.watch) {
+        return 0;
+    }
+#if defined(__linux__)
+    detail::Watcher watcher;
+    if (!watcher.is_valid()) {
+        std::cerr << "[FAIL] Can't watch resources for changes" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> const args(argv + 1, argv + argc);
+    for (;;) {
+        auto const response_files = detail::_response_files(args);
+        for (auto const& path : response_files) {
+            watcher.add(path);
+        }
+        for (auto const& input : options.inputs) {
+            if (input.file != "-") {
+                watcher.add(input.file);
+            }
+        }
+        auto const directories = detail::_walked_directories(options.given);
+        for (auto const& dir : directories) {
+            watcher.add_directory(dir);
+        }
+        auto const changed = watcher.wait(100);
+        auto reconfigure = std::any_of(
+                    response_files.begin(), response_files.end(),
+                    [&changed] (std::string const& path)
+        { return changed.count(detail::_absolute_path(path)) != 0; });
+        // an invalid edit is reported and the previous options are kept
+        // until the next one
+        if (reconfigure && !configure(options)) {
+            std::cout << "[WARN] The previous options are kept" << std::endl;
+        } else if (reconfigure) {
+            if (detail::_needs_probe(options) && costs.empty()) {
+                costs = detail::_probe_compiler(options);
+            }
+            // the filters may have changed
+            resources.clear();
+        } else if (std::any_of(
+                       directories.begin(), directories.end(),
+                       [&changed] (std::string const& dir)
+        { return changed.count(detail::_absolute_path(dir)) != 0; })) {
+            // files came or went in the directories of the inputs
+            auto inputs = options.given;
+            if (!detail::_expand_inputs(inputs)) {
+                continue;
+            }
+            options.inputs.swap(inputs);
+        }
+        if (!detail::_update_archives(options.inputs, changed)) {
+            continue;
+        }
+        // only changed files are read and encoded again
+        resources = detail::_load_resources(options.inputs, resources, changed);
+        auto is_valid = detail::_apply_filters(options, resources)
+                && detail::_convert_elements(resources)
+                && detail::_add_variants(options, resources)
+                && detail::_add_fingerprints(options, resources);
+        detail::_resolve_modes(options, costs, resources);
+        if (is_valid && detail::_check_limits(options, resources)) {
+            detail::_write_outputs(detail::_generate(options, resources));
+        }
+    }
+#else
+    std::cerr << "[FAIL] Watch mode is only supported on Linux" << std::endl;
+    return 1;
+#endif  // __linux__
 }
@@ -0,0 +1,29 @@
+# helpers of the test scripts, that run in a clean directory 'WORK'
+
+file(REMOVE_RECURSE ${WORK})
+file(MAKE_DIRECTORY ${WORK})
+
+set(DATA ${TESTS}/data)
+
+# runs a command in 'WORK', failing the test if it fails
+function(run)
+    execute_process(COMMAND ${ARGN}
+                    WORKING_DIRECTORY ${WORK}
+                    RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        string(REPLACE ";" " " command "${ARGN}")
+        message(FATAL_ERROR "'${command}' failed: ${result}")
+    endif()
+endfunction()
+
+# decompresses the gzip file 'name' of 'WORK' and compares it with 'expected'
+function(check_gunzip name expected)
+    execute_process(COMMAND ${GZIP} -dc ${name}
+                    WORKING_DIRECTORY ${WORK}
+                    OUTPUT_FILE ${WORK}/${name}.out
+                    RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "'${name}' isn't a gzip file: ${result}")
+    endif()
+    run(${CMAKE_COMMAND} -E compare_files ${name}.out ${expected})
+endfunction()
@@ -0,0 +1,18 @@
+# the built-in encoders: gzip and cbor filters, typed arrays, minifiers and
+# the variants, hashes and content negotiation of --precompress
+
+include(${TESTS}/common.cmake)
+
+configure_file(${DATA}/lorem.txt ${WORK}/lorem.log COPYONLY)
+run(${GENERES} -o resources.hpp --filter json=cbor --filter log=gzip
+    --minify --precompress gzip
+    ${DATA}/data.json:data ${DATA}/numbers.txt:numbers:array:i32
+    ${DATA}/style.css:style ${DATA}/page.html:page
+    ${DATA}/lorem.txt:lorem lorem.log:lorem.log)
+run(${CXX} -std=c++11 -I${WORK} -o check ${TESTS}/encoders.cpp)
+file(SHA384 ${DATA}/lorem.txt sha384)
+file(SHA256 ${DATA}/lorem.txt sha256)
+string(SUBSTRING ${sha256} 0 32 etag)
+run(${WORK}/check ${sha384} ${etag})
+check_gunzip(filtered.gz ${DATA}/lorem.txt)
+check_gunzip(variant.gz ${DATA}/lorem.txt)
@@ -0,0 +1,130 @@
+// checks the built-in encoders, given the SHA-384 and the ETag hash of
+// lorem.txt; writes the gzip data to filtered.gz and variant.gz
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "resources.hpp"
+
+static int failures = 0;
+
+inline void
+_expect(bool condition, char const* what)
+{
+    if (!condition) {
+        std::cout << "[FAIL] " << what << std::endl;
+        ++failures;
+    }
+}
+
+inline std::string
+_text(char const* alias)
+{
+    auto const entry = resources::resources_get(alias);
+    return std::string(reinterpret_cast<char const*>(entry.data), entry.size);
+}
+
+inline void
+_write(char const* alias, char const* path)
+{
+    std::ofstream(path, std::ios::binary) << _text(alias);
+}
+
+// the subresource integrity value of a SHA-384 in hex
+inline std::string
+_integrity(std::string const& hex)
+{
+    static char const digits[] =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string bytes;
+    for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes.push_back(char(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    std::string res = "sha384-";
+    // 48 bytes, no padding
+    for (std::size_t i = 0; i + 2 < bytes.size(); i += 3) {
+        auto const bits = std::uint32_t(std::uint8_t(bytes[i])) << 16
+                | std::uint32_t(std::uint8_t(bytes[i + 1])) << 8
+                | std::uint32_t(std::uint8_t(bytes[i + 2]));
+        for (int shift = 18; shift >= 0; shift -= 6) {
+            res.push_back(digits[(bits >> shift) & 0x3f]);
+        }
+    }
+    return res;
+}
+
+inline std::string
+_coding(char const* accept_encoding)
+{
+    auto const res = resources::resources_get_encoded("lorem",
+                                                      accept_encoding);
+    return res.encoding ? res.encoding : "identity";
+}
+
+int
+main(int argc, char const* argv[])
+{
+    if (argc != 3) {
+        std::cout << "[FAIL] Usage: " << argv[0] << " sha384 etag"
+                  << std::endl;
+        return 1;
+    }
+
+    // cbor
+    auto const data = resources::resources_get("data");
+    cpp_generes::cbor const view(data.data, data.size);
+    _expect(view["name"].as_string() == "generes", "cbor text");
+    auto const list = view["list"];
+    _expect(list.size() == 5, "cbor array size");
+    _expect(list[0].as_int() == 1, "cbor integer");
+    _expect(list[1].as_int() == -2, "cbor negative integer");
+    _expect(list[2].as_double() == 2.5, "cbor real");
+    _expect(list[3].as_bool(), "cbor boolean");
+    _expect(list[4].type() == cpp_generes::cbor::null, "cbor null");
+    _expect(view["nested"]["key"].as_string() == "value", "cbor map");
+    _expect(!view["missing"], "cbor missing key");
+
+    // typed arrays
+    auto const element = resources::resources_type("numbers");
+    _expect(element.kind == 'i' && element.size == 4, "typed element");
+    auto const numbers = resources::resources_get_span<std::int32_t>(
+                "numbers");
+    std::int32_t const expected[] = { 1, -2, 3, 2147483647, -2147483647 - 1 };
+    _expect(numbers.size == 5
+            && std::memcmp(numbers.data, expected, sizeof(expected)) == 0,
+            "typed elements");
+    _expect(!resources::resources_get_span<float>("numbers").data,
+            "typed mismatch");
+
+    // minifiers
+    _expect(_text("style") == "body{color:red;margin:0 auto}", "css");
+    _expect(_text("page") == "<!DOCTYPE html> <html> <body> <p>1 < 2 and "
+                             "a &lt; b</p> </body> </html>", "html");
+
+    // --precompress
+    auto const tag = std::string(argv[2]);
+    auto const identity = resources::resources_get_encoded("lorem", "");
+    _expect(identity.integrity == _integrity(argv[1]), "integrity");
+    _expect(identity.etag == "\"" + tag + "\"", "etag");
+    auto const gzip = resources::resources_get_encoded("lorem", "gzip");
+    _expect(gzip.integrity == _integrity(argv[1]), "variant integrity");
+    _expect(gzip.etag == "\"" + tag + "-gz\"", "variant etag");
+    _expect(gzip.size < identity.size, "variant size");
+    _expect(_coding("gzip") == "gzip", "accept gzip");
+    _expect(_coding("x-gzip, deflate") == "gzip", "accept x-gzip");
+    _expect(_coding("GZIP;q=0.5") == "gzip", "accept weighted gzip");
+    _expect(_coding("gzip;q=0") == "identity", "refuse gzip");
+    _expect(_coding("identity;q=1, gzip;q=0.9") == "identity",
+            "prefer identity");
+    _expect(_coding("identity;q=0, *") == "gzip", "accept any");
+    _expect(_coding("br") == "identity", "missing variant");
+    _expect(_coding("") == "identity", "no header");
+
+    // gzip, decompressed by the script
+    _write("lorem.log", "filtered.gz");
+    _write("lorem.gz", "variant.gz");
+    return failures == 0 ? 0 : 1;
+}
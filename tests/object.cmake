@@ -0,0 +1,10 @@
+# --mode object: the written object links with 'LINKER', also when unused
+# sections are collected, and holds the files byte for byte
+
+include(${TESTS}/common.cmake)
+
+run(${GENERES} -o resources.hpp --mode object
+    ${DATA}/hello.txt:hello ${DATA}/empty.txt:empty ${GENERES}:program)
+run(${CXX} -std=c++11 -fuse-ld=${LINKER} -Wl,--gc-sections -I${WORK}
+    -o check ${TESTS}/object.cpp resources_data.o)
+run(${WORK}/check ${DATA}/hello.txt ${DATA}/empty.txt ${GENERES})
@@ -0,0 +1,44 @@
+// checks the resources written by --mode object against their files, given
+// in the order hello, empty, program
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "resources.hpp"
+
+inline bool
+_is_same(char const* alias, char const* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string const data((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    auto const entry = resources::resources_get(alias);
+    if (!file || !entry.data || entry.size != data.size()
+            || std::memcmp(entry.data, data.data(), data.size()) != 0) {
+        std::cout << "[FAIL] Resource '" << alias << "' differs from '"
+                  << path << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int
+main(int argc, char const* argv[])
+{
+    if (argc != 4) {
+        std::cout << "[FAIL] Usage: " << argv[0] << " hello empty program"
+                  << std::endl;
+        return 1;
+    }
+    auto res = _is_same("hello", argv[1]);
+    res = _is_same("empty", argv[2]) && res;
+    res = _is_same("program", argv[3]) && res;
+    if (resources::resources_get("missing").data) {
+        std::cout << "[FAIL] Resource 'missing' was found" << std::endl;
+        res = false;
+    }
+    return res ? 0 : 1;
+}
@@ -0,0 +1,72 @@
+// minimal local stand-in for rue-ryuzaki/argparse, used only for compile checks
+#pragma once
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+namespace argparse {
+enum Formatter { ArgumentDefaultsHelpFormatter };
+struct Argument {
+    std::vector<std::string> flags; std::string act = "store"; std::string nrg; std::string def; bool has_def = false;
+    std::vector<std::string> ch;
+    Argument& action(std::string const& a) { act = a; return *this; }
+    Argument& version(std::string const&) { return *this; }
+    Argument& nargs(std::string const& n) { nrg = n; return *this; }
+    Argument& nargs(int) { return *this; }
+    Argument& metavar(std::string const&) { return *this; }
+    Argument& help(std::string const&) { return *this; }
+    Argument& dest(std::string const&) { return *this; }
+    Argument& required(bool) { return *this; }
+    template <class T> Argument& type() { return *this; }
+    Argument& choices(std::initializer_list<std::string> c) { ch = c; return *this; }
+    template <class T> Argument& default_value(T const& v) { std::ostringstream s; s << v; def = s.str(); has_def = true; return *this; }
+    Argument& const_value(std::string const&) { return *this; }
+    std::string key() const { std::string k = flags.back(); while (!k.empty() && k[0] == '-') k.erase(0, 1); for (auto& c : k) if (c == '-') c = '_'; return k; }
+};
+struct Namespace {
+    std::map<std::string, std::vector<std::string> > v;
+    bool exists(std::string const& k) const { return v.count(k) != 0; }
+    template <class T> T get(std::string const& k) const { T t{}; auto it = v.find(k); if (it == v.end() || it->second.empty()) return t; std::istringstream s(it->second.back()); s >> t; return t; }
+    template <class T> T get(std::string const& k, char sep) const { T t; auto it = v.find(k); if (it == v.end()) return t; for (auto const& s : it->second) { auto p = s.find(sep); if (p == std::string::npos) t.emplace_back(s, std::string()); else t.emplace_back(s.substr(0, p), s.substr(p + 1)); } return t; }
+};
+template <> inline std::string Namespace::get<std::string>(std::string const& k) const { auto it = v.find(k); return it == v.end() || it->second.empty() ? std::string() : it->second.back(); }
+template <> inline bool Namespace::get<bool>(std::string const& k) const { auto it = v.find(k); return it != v.end() && !it->second.empty() && it->second.back() == "1"; }
+template <> inline std::vector<std::string> Namespace::get<std::vector<std::string> >(std::string const& k) const { auto it = v.find(k); return it == v.end() ? std::vector<std::string>() : it->second; }
+class ArgumentParser {
+    std::vector<std::string> a; std::vector<Argument*> args;
+public:
+    ArgumentParser(int argc, char const* argv[]) : a(argv + 1, argv + argc) {}
+    ArgumentParser(ArgumentParser const&) = default;
+    ~ArgumentParser() {}
+    ArgumentParser& description(std::string const&) { return *this; }
+    ArgumentParser& epilog(std::string const&) { return *this; }
+    ArgumentParser& fromfile_prefix_chars(std::string const&) { return *this; }
+    ArgumentParser& formatter_class(Formatter) { return *this; }
+    template <class... F> Argument& add_argument(F... f) { auto* r = new Argument(); r->flags = { f... }; args.push_back(r); return *r; }
+    Namespace parse_args() const { return parse_args(a); }
+    Namespace parse_args(std::vector<std::string> in) const {
+        std::vector<std::string> x;
+        for (auto const& s : in) { if (!s.empty() && s[0] == '@') { std::ifstream f(s.substr(1)); std::string l; while (std::getline(f, l)) if (!l.empty()) x.push_back(l); } else x.push_back(s); }
+        Namespace ns;
+        for (auto* g : args) { if (g->has_def) ns.v[g->key()] = { g->def }; if (g->act == "store_true") ns.v[g->key()] = { "0" }; if (g->flags[0][0] != '-' || g->act == "append" || g->act == "extend") ns.v[g->key()].clear(); }
+        bool rest = false;
+        for (std::size_t i = 0; i < x.size(); ++i) {
+            Argument* m = nullptr;
+            if (!rest && x[i] == "--") { rest = true; continue; }
+            if (!rest && x[i].size() > 1 && x[i][0] == '-') { for (auto* g : args) for (auto const& f : g->flags) if (f == x[i]) m = g; if (!m) { std::cerr << "unknown " << x[i] << "\n"; std::exit(2); } }
+            if (!m) { for (auto* g : args) if (g->flags[0][0] != '-') ns.v[g->key()].push_back(x[i]); continue; }
+            if (m->act == "version") { std::cout << "version\n"; std::exit(0); }
+            if (m->act == "store_true") { ns.v[m->key()] = { "1" }; continue; }
+            if (m->act == "append" || m->act == "extend") { ns.v[m->key()].push_back(x[++i]); continue; }
+            ns.v[m->key()] = { x[++i] };
+        }
+        return ns;
+    }
+};
+}  // namespace argparse